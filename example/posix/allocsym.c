@@ -0,0 +1,96 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+/*
+    Host tool: allocation sites of profiling report (KERNEL_ALLOC_PROFILING), printed by process_info() and
+    heap_profile(), to function and source line with addr2line against ELF. Other lines are passed as is:
+    build/rexos_posix | build/allocsym build/rexos_posix
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#define ALLOCSYM_MAX_SITES                      256
+#define ALLOCSYM_LINE_SIZE                      256
+#define ALLOCSYM_NAME_SIZE                      128
+
+typedef struct {
+    unsigned int addr;
+    char name[ALLOCSYM_NAME_SIZE];
+} ALLOCSYM_SITE;
+
+typedef struct {
+    const char* elf;
+    ALLOCSYM_SITE sites[ALLOCSYM_MAX_SITES];
+    unsigned int sites_count;
+} ALLOCSYM;
+
+static void allocsym_strip(char* str)
+{
+    str[strcspn(str, "\r\n")] = 0;
+}
+
+static void allocsym_addr2line(ALLOCSYM* a, unsigned int addr, char* name)
+{
+    char cmd[ALLOCSYM_LINE_SIZE];
+    char func[ALLOCSYM_NAME_SIZE / 2], line[ALLOCSYM_NAME_SIZE / 2];
+    FILE* pipe;
+    strcpy(name, "??");
+    //caller is return address: call itself is before
+    snprintf(cmd, sizeof(cmd), "addr2line -f -s -e '%s' 0x%x", a->elf, addr - 1);
+    if ((pipe = popen(cmd, "r")) == NULL)
+        return;
+    if (fgets(func, sizeof(func), pipe) != NULL && fgets(line, sizeof(line), pipe) != NULL)
+    {
+        allocsym_strip(func);
+        allocsym_strip(line);
+        snprintf(name, ALLOCSYM_NAME_SIZE, "%s %s", func, line);
+    }
+    pclose(pipe);
+}
+
+static const char* allocsym_resolve(ALLOCSYM* a, unsigned int addr)
+{
+    static char name[ALLOCSYM_NAME_SIZE];
+    unsigned int i;
+    for (i = 0; i < a->sites_count; ++i)
+        if (a->sites[i].addr == addr)
+            return a->sites[i].name;
+    allocsym_addr2line(a, addr, name);
+    if (a->sites_count >= ALLOCSYM_MAX_SITES)
+        return name;
+    a->sites[i].addr = addr;
+    strcpy(a->sites[i].name, name);
+    return a->sites[a->sites_count++].name;
+}
+
+int main(int argc, char* argv[])
+{
+    static ALLOCSYM a;
+    char line[ALLOCSYM_LINE_SIZE];
+    unsigned int addr;
+    int len;
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: allocsym <elf>\n");
+        return 1;
+    }
+    a.elf = argv[1];
+    //target is never exiting: report must be seen as soon as printed
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        //site line: "0x0040B6D7    88    88      2"
+        if (sscanf(line, "0x%8x%n", &addr, &len) == 1 && len == 10 && line[len] == ' ')
+        {
+            allocsym_strip(line);
+            printf("%s  %s\n", line, allocsym_resolve(&a, addr));
+        }
+        else
+            fputs(line, stdout);
+    }
+    return 0;
+}
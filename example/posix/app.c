@@ -0,0 +1,216 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "../../userspace/stdio.h"
+#include "../../userspace/process.h"
+#include "../../userspace/ipc.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/svc.h"
+#include "../../userspace/object.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+#include "../../userspace/posix/posix_driver.h"
+#include "app_private.h"
+#include "disk.h"
+#include "net.h"
+#include "bench.h"
+#include "trace_dump.h"
+#include "config.h"
+
+#define APP_TICK_MS                             1000
+#define APP_TICKS                               3
+
+void app();
+void echo();
+
+const REX __APP = {
+    //name
+    "App main",
+    //size
+    2048,
+    //priority
+    200,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    app
+};
+
+static const REX __ECHO = {
+    //name
+    "Echo server",
+    //size
+    2048,
+    //priority
+    150,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    echo
+};
+
+//sample server: reply on every request with incremented param
+void echo()
+{
+    IPC ipc;
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case ECHO_REQUEST:
+            ipc.param2 = ipc.param1 + 1;
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+static inline void stat()
+{
+    SYSTIME uptime;
+    int i;
+    unsigned int diff;
+
+    get_uptime(&uptime);
+    for (i = 0; i < TEST_ROUNDS; ++i)
+        svc_test();
+    diff = systime_elapsed_us(&uptime);
+    printf("average kernel call time: %d.%dus\n", diff / TEST_ROUNDS, (diff / (TEST_ROUNDS / 10)) % 10);
+
+    get_uptime(&uptime);
+    for (i = 0; i < TEST_ROUNDS; ++i)
+        process_switch_test();
+    diff = systime_elapsed_us(&uptime);
+    printf("average switch time: %d.%dus\n", diff / TEST_ROUNDS, (diff / (TEST_ROUNDS / 10)) % 10);
+}
+
+static inline void echo_test(HANDLE server)
+{
+    SYSTIME uptime;
+    int i;
+    unsigned int diff, res;
+
+    get_uptime(&uptime);
+    for (i = 0; i < ECHO_ROUNDS; ++i)
+    {
+        res = get(server, HAL_REQ(HAL_APP, ECHO_REQUEST), i, 0, 0);
+        if (res != i + 1)
+        {
+            printf("echo failed: %d, error: %d\n", res, get_last_error());
+            return;
+        }
+    }
+    diff = systime_elapsed_us(&uptime);
+    printf("average echo call time: %d.%dus\n", diff / ECHO_ROUNDS, (diff / (ECHO_ROUNDS / 10)) % 10);
+}
+
+static inline void app_init(APP* app)
+{
+    //stdout is ready on return: console is above app priority
+    app->console = process_create(&__POSIX_CONSOLE);
+    open_stdout();
+    printf("App init\n");
+    app->timer = timer_create(0, HAL_APP);
+    app->ticks = 0;
+}
+
+//kernel events of HTTP request, for host decoder
+static inline void app_trace(APP* app)
+{
+    const TRACE_DUMP_NAME names[] = {
+        {process_get_current(), "App main"},
+        {app->console, "POSIX console"},
+        {app->disk.storage, "POSIX disk"},
+        {app->disk.vfs, "VFS stack"},
+        {object_get(SYS_OBJ_ETH), "POSIX ETH"},
+        {app->net.server, "TCP/IP server"},
+        {app->net.client, "TCP/IP client"},
+        {app->net.webs, "Web Server"},
+        {app->net.http_client, "HTTP client"}
+    };
+    trace_dump(names, sizeof(names) / sizeof(TRACE_DUMP_NAME));
+}
+
+static inline void app_http_done(APP* app, int res, unsigned int us)
+{
+    app_trace(app);
+    if (res < 0)
+        printf("HTTP GET failed\n");
+    else
+        printf("HTTP GET: %d.%03d ms\n", us / 1000, us % 1000);
+    timer_start_periodic_ms(app->timer, APP_TICK_MS);
+}
+
+static inline void app_timeout(APP* app)
+{
+    SYSTIME uptime;
+    get_uptime(&uptime);
+    printf("tick: %d.%06d\n", uptime.sec, uptime.usec);
+    if (++app->ticks < APP_TICKS)
+        return;
+    timer_stop(app->timer, 0, HAL_APP);
+    process_info();
+    printf("App done\n");
+}
+
+static inline void app_request(APP* app, IPC* ipc)
+{
+    switch (HAL_ITEM(ipc->cmd))
+    {
+    case IPC_TIMEOUT:
+        app_timeout(app);
+        break;
+    case NET_HTTP_DONE:
+        app_http_done(app, (int)ipc->param2, ipc->param3);
+        break;
+    default:
+        error(ERROR_NOT_SUPPORTED);
+        break;
+    }
+}
+
+void app()
+{
+    APP app;
+    IPC ipc;
+    HANDLE echo;
+
+    app_init(&app);
+    stat();
+    echo = process_create(&__ECHO);
+    echo_test(echo);
+    bench_ipc(echo);
+    bench_timer();
+    bench_ready();
+    bench_inversion();
+    bench_stream();
+    bench_pool();
+    disk_init(&app);
+    net_init(&app);
+
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_GROUP(ipc.cmd))
+        {
+        case HAL_IP:
+        case HAL_WEBS:
+            net_request(&app, &ipc);
+            break;
+        case HAL_APP:
+            app_request(&app, &ipc);
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
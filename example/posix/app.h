@@ -0,0 +1,18 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef APP_H
+#define APP_H
+
+#include "../../userspace/ipc.h"
+
+typedef struct _APP APP;
+
+typedef enum {
+    ECHO_REQUEST = IPC_USER
+} ECHO_IPCS;
+
+#endif // APP_H
@@ -0,0 +1,21 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef APP_PRIVATE_H
+#define APP_PRIVATE_H
+
+#include "disk.h"
+#include "net.h"
+#include "../../userspace/types.h"
+
+typedef struct _APP {
+    DISK disk;
+    NET net;
+    HANDLE console, timer;
+    unsigned int ticks;
+} APP;
+
+#endif // APP_PRIVATE_H
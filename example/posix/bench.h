@@ -0,0 +1,33 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "../../userspace/types.h"
+#include "../../userspace/ipc.h"
+
+typedef enum {
+    BENCH_RUN = IPC_USER,
+    BENCH_FILL,
+    BENCH_WORK
+} BENCH_IPCS;
+
+//selective receive at IPC queue depth 8, 32 and 128
+void bench_ipc(HANDLE echo);
+//kernel timers start, stop and expiry with 10 to 5000 active
+void bench_timer();
+//scheduler wakeup with 2 to 64 ready processes
+void bench_ready();
+//high priority call to low priority server, preempted by medium: post and wait vs call
+void bench_inversion();
+//stream ring copy byte by byte vs spans, stream write and read with 1, 64 and 4096 bytes
+void bench_stream();
+//webs/tcpips allocation trace replay to first-fit and TLSF pool: avg time per operation, free slots,
+//fragmentation after 10^6 operations
+void bench_pool();
+
+#endif // BENCH_H
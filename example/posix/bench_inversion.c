@@ -0,0 +1,167 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "bench.h"
+#include "config.h"
+#include "../../userspace/process.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+
+/*
+    Priority inversion: bench (high) is calling server (low). While serving, server wakes hog (medium).
+    Without inheritance hog preempts server and bench is waiting for whole hog run.
+    Asynchronous post and wait for response is not inheriting, like any call before.
+*/
+
+void bench_inversion_main();
+void bench_inversion_server();
+void bench_inversion_hog();
+
+static const REX __BENCH_INVERSION = {
+    //name
+    "Inversion bench",
+    //size
+    BENCH_PROCESS_SIZE,
+    //priority
+    BENCH_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_inversion_main
+};
+
+static const REX __BENCH_INVERSION_SERVER = {
+    //name
+    "Inversion server",
+    //size
+    BENCH_FILLER_PROCESS_SIZE,
+    //priority
+    BENCH_SERVER_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_inversion_server
+};
+
+static const REX __BENCH_INVERSION_HOG = {
+    //name
+    "Inversion hog",
+    //size
+    BENCH_FILLER_PROCESS_SIZE,
+    //priority
+    BENCH_HOG_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_inversion_hog
+};
+
+static void bench_inversion_spin(unsigned int us)
+{
+    SYSTIME uptime;
+    get_uptime(&uptime);
+    while (systime_elapsed_us(&uptime) < us) {}
+}
+
+void bench_inversion_hog()
+{
+    IPC ipc;
+    for (;;)
+    {
+        ipc_read(&ipc);
+        bench_inversion_spin(BENCH_HOG_US);
+        ipc_write(&ipc);
+    }
+}
+
+void bench_inversion_server()
+{
+    IPC ipc;
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_WORK:
+            ipc_post_inline((HANDLE)ipc.param2, HAL_CMD(HAL_APP, BENCH_FILL), 0, 0, 0);
+            bench_inversion_spin(BENCH_SERVER_US);
+            //asynchronous request
+            if ((ipc.cmd & HAL_REQ_FLAG) == 0)
+                ipc_post(&ipc);
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+static void bench_inversion_mode(HANDLE server, HANDLE hog, bool sync)
+{
+    SYSTIME uptime;
+    IPC ipc;
+    unsigned int i, us, total, max;
+    for (i = 0, total = max = 0; i < BENCH_INVERSION_ROUNDS; ++i)
+    {
+        get_uptime(&uptime);
+        if (sync)
+            ack(server, HAL_REQ(HAL_APP, BENCH_WORK), i, hog, 0);
+        else
+        {
+            ipc_post_inline(server, HAL_CMD(HAL_APP, BENCH_WORK), i, hog, 0);
+            ipc_read_ex(&ipc, server, HAL_CMD(HAL_APP, BENCH_WORK), i);
+        }
+        us = systime_elapsed_us(&uptime);
+        total += us;
+        if (us > max)
+            max = us;
+        //let hog finish before next round
+        sleep_ms(BENCH_HOG_US / 1000 + 1);
+    }
+    printf("%-10s %7d %7d\n", sync ? "call" : "post", total / BENCH_INVERSION_ROUNDS, max);
+}
+
+static inline void bench_inversion_run()
+{
+    HANDLE server, hog;
+    server = process_create(&__BENCH_INVERSION_SERVER);
+    hog = process_create(&__BENCH_INVERSION_HOG);
+    printf("inversion   avg us  max us\n");
+    bench_inversion_mode(server, hog, false);
+    bench_inversion_mode(server, hog, true);
+    process_destroy(hog);
+    process_destroy(server);
+}
+
+void bench_inversion_main()
+{
+    IPC ipc;
+    open_stdout();
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_RUN:
+            bench_inversion_run();
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+void bench_inversion()
+{
+    HANDLE bench = process_create(&__BENCH_INVERSION);
+    ack(bench, HAL_REQ(HAL_APP, BENCH_RUN), 0, 0, 0);
+    process_destroy(bench);
+}
@@ -0,0 +1,97 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "bench.h"
+#include "app.h"
+#include "config.h"
+#include "../../userspace/process.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+
+//ring is holding size - 1 items: deepest fill and response
+#define BENCH_IPC_QUEUE_SIZE                    130
+
+void bench_ipc_main();
+
+static const REX __BENCH_IPC = {
+    //name
+    "IPC bench",
+    //size
+    BENCH_PROCESS_SIZE,
+    //priority
+    BENCH_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_ipc_main,
+    //ipc size
+    BENCH_IPC_QUEUE_SIZE
+};
+
+static const unsigned int __BENCH_IPC_DEPTHS[] = {0, 8, 32, 128};
+
+static void bench_ipc_depth(HANDLE echo, unsigned int depth)
+{
+    SYSTIME uptime;
+    HANDLE self;
+    unsigned int i, call_us, miss_us;
+    self = process_get_current();
+    //unrelated IPCs, waiting on queue
+    for (i = 0; i < depth; ++i)
+        ipc_post_inline(self, HAL_CMD(HAL_APP, BENCH_FILL), i, 0, 0);
+
+    //response is posted behind them: filter is passed, ring is scanned
+    get_uptime(&uptime);
+    for (i = 0; i < BENCH_IPC_ROUNDS; ++i)
+        get(echo, HAL_REQ(HAL_APP, ECHO_REQUEST), i, 0, 0);
+    call_us = systime_elapsed_us(&uptime);
+
+    //not on queue: rejected by filter without scan
+    get_uptime(&uptime);
+    for (i = 0; i < BENCH_IPC_ROUNDS; ++i)
+        ipc_remove(echo, HAL_CMD(HAL_APP, ECHO_REQUEST), ANY_HANDLE);
+    miss_us = systime_elapsed_us(&uptime);
+
+    ipc_remove(self, HAL_CMD(HAL_APP, BENCH_FILL), ANY_HANDLE);
+    printf("%9d %8d %8d\n", depth, call_us * 1000 / BENCH_IPC_ROUNDS, miss_us * 1000 / BENCH_IPC_ROUNDS);
+}
+
+static inline void bench_ipc_run(HANDLE echo)
+{
+    int i;
+    printf("IPC depth  call ns  miss ns\n");
+    for (i = 0; i < sizeof(__BENCH_IPC_DEPTHS) / sizeof(unsigned int); ++i)
+        bench_ipc_depth(echo, __BENCH_IPC_DEPTHS[i]);
+}
+
+void bench_ipc_main()
+{
+    IPC ipc;
+    open_stdout();
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_RUN:
+            bench_ipc_run((HANDLE)ipc.param1);
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+void bench_ipc(HANDLE echo)
+{
+    HANDLE bench = process_create(&__BENCH_IPC);
+    ack(bench, HAL_REQ(HAL_APP, BENCH_RUN), echo, 0, 0);
+    process_destroy(bench);
+}
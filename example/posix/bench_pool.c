@@ -0,0 +1,312 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "bench.h"
+#include "config.h"
+#include "../../userspace/process.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/stdlib.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+#include "../../lib/pool.h"
+#include <string.h>
+
+/*
+    Allocation trace of webs/tcpips sessions, replayed to first-fit and TLSF pool in private arena.
+    Session: tcb and request header are allocated on accept, request is growing by realloc on every received
+    chunk, temporary response is allocated and freed, session is freed on close. Web nodes are long living.
+*/
+
+#define BENCH_POOL_SESSIONS                     8
+//tcb, request and response of each session
+#define BENCH_POOL_SESSION_SLOTS                3
+#define BENCH_POOL_NODES                        64
+#define BENCH_POOL_SLOTS                        (BENCH_POOL_SESSIONS * BENCH_POOL_SESSION_SLOTS + BENCH_POOL_NODES)
+#define BENCH_POOL_SEED                         0x52450001
+
+void bench_pool_main();
+
+static const REX __BENCH_POOL = {
+    //name
+    "Pool bench",
+    //size
+    BENCH_POOL_PROCESS_SIZE,
+    //priority
+    BENCH_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_pool_main
+};
+
+typedef enum {
+    BENCH_POOL_MALLOC = 0,
+    BENCH_POOL_REALLOC,
+    BENCH_POOL_FREE
+} BENCH_POOL_OP_TYPE;
+
+typedef struct {
+    uint8_t op;
+    uint8_t slot;
+    uint16_t size;
+} BENCH_POOL_OP;
+
+typedef enum {
+    BENCH_POOL_CLOSED = 0,
+    BENCH_POOL_RECEIVING,
+    BENCH_POOL_RESPONDING,
+    BENCH_POOL_CLOSING
+} BENCH_POOL_SESSION_STATE;
+
+typedef struct {
+    unsigned int seed;
+    uint8_t sessions[BENCH_POOL_SESSIONS];
+    uint16_t sizes[BENCH_POOL_SLOTS];
+} BENCH_POOL_TRACE;
+
+typedef struct {
+    POOL pool;
+    void* ptrs[BENCH_POOL_SLOTS];
+    unsigned int failed;
+} BENCH_POOL_REPLAY;
+
+typedef struct {
+    BENCH_POOL_OP ops[BENCH_POOL_OPS];
+    BENCH_POOL_TRACE trace;
+    BENCH_POOL_REPLAY replay;
+    char arena[BENCH_POOL_ARENA_SIZE];
+} BENCH_POOL;
+
+//rand() is mixed with uptime, but trace must be same on every run
+static unsigned int bench_pool_random(BENCH_POOL_TRACE* trace, unsigned int from, unsigned int to)
+{
+    trace->seed = trace->seed * 1103515245 + 12345;
+    return from + (trace->seed >> 16) % (to - from + 1);
+}
+
+static void bench_pool_trace_init(BENCH_POOL_TRACE* trace)
+{
+    memset(trace, 0, sizeof(BENCH_POOL_TRACE));
+    trace->seed = BENCH_POOL_SEED;
+}
+
+static void bench_pool_trace_op(BENCH_POOL_TRACE* trace, BENCH_POOL_OP* op, BENCH_POOL_OP_TYPE type, unsigned int slot,
+                                unsigned int size)
+{
+    op->op = type;
+    op->slot = slot;
+    op->size = size;
+    trace->sizes[slot] = type == BENCH_POOL_FREE ? 0 : size;
+}
+
+//next operation of random session or web node
+static void bench_pool_trace_next(BENCH_POOL_TRACE* trace, BENCH_POOL_OP* op)
+{
+    unsigned int session, slot;
+    //web node name
+    if (bench_pool_random(trace, 0, 15) == 0)
+    {
+        slot = BENCH_POOL_SESSIONS * BENCH_POOL_SESSION_SLOTS + bench_pool_random(trace, 0, BENCH_POOL_NODES - 1);
+        if (trace->sizes[slot])
+            bench_pool_trace_op(trace, op, BENCH_POOL_FREE, slot, 0);
+        else
+            bench_pool_trace_op(trace, op, BENCH_POOL_MALLOC, slot, bench_pool_random(trace, 8, 40));
+        return;
+    }
+    session = bench_pool_random(trace, 0, BENCH_POOL_SESSIONS - 1);
+    slot = session * BENCH_POOL_SESSION_SLOTS;
+    switch (trace->sessions[session])
+    {
+    case BENCH_POOL_CLOSED:
+        //tcb, then request header on next step
+        if (trace->sizes[slot] == 0)
+        {
+            bench_pool_trace_op(trace, op, BENCH_POOL_MALLOC, slot, bench_pool_random(trace, 48, 96));
+            break;
+        }
+        bench_pool_trace_op(trace, op, BENCH_POOL_MALLOC, slot + 1, bench_pool_random(trace, 64, 256));
+        trace->sessions[session] = BENCH_POOL_RECEIVING;
+        break;
+    case BENCH_POOL_RECEIVING:
+        //request body chunk
+        bench_pool_trace_op(trace, op, BENCH_POOL_REALLOC, slot + 1,
+                            trace->sizes[slot + 1] + bench_pool_random(trace, 64, 1024));
+        if (trace->sizes[slot + 1] > 2048 || bench_pool_random(trace, 0, 3) == 0)
+            trace->sessions[session] = BENCH_POOL_RESPONDING;
+        break;
+    case BENCH_POOL_RESPONDING:
+        if (trace->sizes[slot + 2] == 0)
+        {
+            bench_pool_trace_op(trace, op, BENCH_POOL_MALLOC, slot + 2, bench_pool_random(trace, 16, 512));
+            break;
+        }
+        bench_pool_trace_op(trace, op, BENCH_POOL_FREE, slot + 2, 0);
+        trace->sessions[session] = BENCH_POOL_CLOSING;
+        break;
+    default:
+        if (trace->sizes[slot + 1])
+        {
+            bench_pool_trace_op(trace, op, BENCH_POOL_FREE, slot + 1, 0);
+            //keep-alive: next request on same tcb
+            if (bench_pool_random(trace, 0, 1))
+                trace->sessions[session] = BENCH_POOL_CLOSED;
+        }
+        else
+        {
+            bench_pool_trace_op(trace, op, BENCH_POOL_FREE, slot, 0);
+            trace->sessions[session] = BENCH_POOL_CLOSED;
+        }
+        break;
+    }
+}
+
+static void bench_pool_replay_init(BENCH_POOL* bench, bool tlsf)
+{
+    memset(&bench->replay, 0, sizeof(BENCH_POOL_REPLAY));
+#if (KERNEL_POOL_TLSF)
+    if (tlsf)
+        pool_init_tlsf(&bench->replay.pool, bench->arena);
+    else
+#endif //KERNEL_POOL_TLSF
+        pool_init(&bench->replay.pool, bench->arena);
+}
+
+static void bench_pool_replay_op(BENCH_POOL* bench, const BENCH_POOL_OP* op)
+{
+    BENCH_POOL_REPLAY* replay = &bench->replay;
+    void* sp = bench->arena + BENCH_POOL_ARENA_SIZE;
+    void* ptr;
+    switch (op->op)
+    {
+    case BENCH_POOL_MALLOC:
+        if ((replay->ptrs[op->slot] = pool_malloc(&replay->pool, op->size, sp)) == NULL)
+            ++replay->failed;
+        break;
+    case BENCH_POOL_REALLOC:
+        if ((ptr = pool_realloc(&replay->pool, replay->ptrs[op->slot], op->size, sp)) == NULL)
+            ++replay->failed;
+        else
+            replay->ptrs[op->slot] = ptr;
+        break;
+    default:
+        pool_free(&replay->pool, replay->ptrs[op->slot]);
+        replay->ptrs[op->slot] = NULL;
+        break;
+    }
+}
+
+//best of few runs: host is preempting us
+static unsigned int bench_pool_replay_ns(BENCH_POOL* bench, bool tlsf)
+{
+    SYSTIME uptime;
+    unsigned int i, j, us, best;
+    for (j = 0, best = 0; j < BENCH_POOL_RUNS; ++j)
+    {
+        bench_pool_replay_init(bench, tlsf);
+        get_uptime(&uptime);
+        for (i = 0; i < BENCH_POOL_OPS; ++i)
+            bench_pool_replay_op(bench, &bench->ops[i]);
+        us = systime_elapsed_us(&uptime);
+        if (j == 0 || us < best)
+            best = us;
+    }
+    return best * 1000 / BENCH_POOL_OPS;
+}
+
+static void bench_pool_replay(BENCH_POOL* bench, bool tlsf)
+{
+    POOL_STAT stat;
+    unsigned int ns;
+    ns = bench_pool_replay_ns(bench, tlsf);
+    if (!pool_check(&bench->replay.pool, bench->arena + BENCH_POOL_ARENA_SIZE))
+        printf("Pool bench: pool corrupted\n");
+    //first-fit is walking free slots on every malloc. Space to arena end is counted too
+    pool_stat(&bench->replay.pool, &stat, bench->arena + BENCH_POOL_ARENA_SIZE);
+    printf("%-10s %7d %10d %7d\n", tlsf ? "tlsf" : "first-fit", ns, stat.free_slots, bench->replay.failed);
+}
+
+//long run, generated on the fly: peak and final brk, free slots without space to arena end, largest free slot
+static void bench_pool_fragmentation(BENCH_POOL* bench, bool tlsf)
+{
+    BENCH_POOL_OP op;
+    POOL_STAT stat;
+    unsigned int i, brk, peak, index;
+    bench_pool_trace_init(&bench->trace);
+    bench_pool_replay_init(bench, tlsf);
+    for (i = 0, peak = 0; i < BENCH_POOL_FRAGMENTATION_OPS; ++i)
+    {
+        bench_pool_trace_next(&bench->trace, &op);
+        bench_pool_replay_op(bench, &op);
+        brk = (char*)bench->replay.pool.last_slot - bench->arena;
+        if (brk > peak)
+            peak = brk;
+        if ((i % BENCH_POOL_CHECK_OPS) == 0 && !pool_check(&bench->replay.pool, bench->arena + BENCH_POOL_ARENA_SIZE))
+        {
+            printf("Pool bench: pool corrupted on op %d\n", i);
+            return;
+        }
+    }
+    pool_stat(&bench->replay.pool, &stat, bench->replay.pool.last_slot);
+    index = stat.free ? 100 - stat.largest_free * 100 / stat.free : 0;
+    printf("%-10s %8d %8d %6d %8d %5d%%", tlsf ? "tlsf" : "first-fit", peak, brk, stat.free, stat.largest_free, index);
+    //everything is freed: brk must be back on pool start
+    for (i = 0; i < BENCH_POOL_SLOTS; ++i)
+        pool_free(&bench->replay.pool, bench->replay.ptrs[i]);
+    printf(" %8d %7d\n", (char*)bench->replay.pool.last_slot - bench->arena, bench->replay.failed);
+}
+
+static inline void bench_pool_run()
+{
+    BENCH_POOL* bench;
+    int i;
+    if ((bench = malloc(sizeof(BENCH_POOL))) == NULL)
+    {
+        printf("Pool bench: out of memory\n");
+        return;
+    }
+    bench_pool_trace_init(&bench->trace);
+    for (i = 0; i < BENCH_POOL_OPS; ++i)
+        bench_pool_trace_next(&bench->trace, &bench->ops[i]);
+    printf("replay     avg ns free slots  failed\n");
+    bench_pool_replay(bench, false);
+#if (KERNEL_POOL_TLSF)
+    bench_pool_replay(bench, true);
+#endif //KERNEL_POOL_TLSF
+    printf("fragment   brk peak  brk end   free  largest  index    empty  failed\n");
+    bench_pool_fragmentation(bench, false);
+#if (KERNEL_POOL_TLSF)
+    bench_pool_fragmentation(bench, true);
+#endif //KERNEL_POOL_TLSF
+    free(bench);
+}
+
+void bench_pool_main()
+{
+    IPC ipc;
+    open_stdout();
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_RUN:
+            bench_pool_run();
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+void bench_pool()
+{
+    HANDLE bench = process_create(&__BENCH_POOL);
+    ack(bench, HAL_REQ(HAL_APP, BENCH_RUN), 0, 0, 0);
+    process_destroy(bench);
+}
@@ -0,0 +1,130 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "bench.h"
+#include "config.h"
+#include "../../userspace/process.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+
+#define BENCH_READY_MAX                         64
+//every filler reply is on queue at once
+#define BENCH_READY_QUEUE_SIZE                  (BENCH_READY_MAX + 2)
+
+void bench_ready_main();
+void bench_ready_filler();
+
+static const REX __BENCH_READY = {
+    //name
+    "Ready bench",
+    //size
+    BENCH_PROCESS_SIZE,
+    //priority
+    BENCH_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_ready_main,
+    //ipc size
+    BENCH_READY_QUEUE_SIZE
+};
+
+//all fillers are on same priority, below bench: woken filler is queued behind all ready ones
+static const REX __BENCH_READY_FILLER = {
+    //name
+    "Ready filler",
+    //size
+    BENCH_FILLER_PROCESS_SIZE,
+    //priority
+    BENCH_FILLER_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE,
+    //function
+    bench_ready_filler
+};
+
+static const unsigned int __BENCH_READY_COUNTS[] = {2, 4, 8, 16, 32, 64};
+
+void bench_ready_filler()
+{
+    IPC ipc;
+    for (;;)
+    {
+        ipc_read(&ipc);
+        ipc_write(&ipc);
+    }
+}
+
+static void bench_ready_count(HANDLE* fillers, unsigned int count)
+{
+    SYSTIME uptime;
+    IPC ipc;
+    unsigned int i, j, wakeup_us, switch_us;
+    for (i = 0; i < count; ++i)
+    {
+        fillers[i] = process_create(&__BENCH_READY_FILLER);
+        //filler is waiting for request after reply
+        ack(fillers[i], HAL_REQ(HAL_APP, BENCH_FILL), 0, 0, 0);
+    }
+
+    for (j = 0, wakeup_us = switch_us = 0; j < BENCH_READY_ROUNDS; ++j)
+    {
+        //no preemption: every filler is queued to ready list, holding 0..count - 1 processes
+        get_uptime(&uptime);
+        for (i = 0; i < count; ++i)
+            ipc_post_inline(fillers[i], HAL_REQ(HAL_APP, BENCH_FILL), i, 0, 0);
+        wakeup_us += systime_elapsed_us(&uptime);
+
+        //each reply is preempting filler: bench is woken, filler is requeued behind rest of ready
+        get_uptime(&uptime);
+        for (i = 0; i < count; ++i)
+            ipc_read(&ipc);
+        switch_us += systime_elapsed_us(&uptime);
+    }
+
+    for (i = 0; i < count; ++i)
+        process_destroy(fillers[i]);
+    printf("%5d %10d %9d\n", count, wakeup_us * 1000 / (BENCH_READY_ROUNDS * count),
+           switch_us * 1000 / (BENCH_READY_ROUNDS * count));
+}
+
+static inline void bench_ready_run()
+{
+    HANDLE fillers[BENCH_READY_MAX];
+    int i;
+    printf("procs  wakeup ns  reply ns\n");
+    for (i = 0; i < sizeof(__BENCH_READY_COUNTS) / sizeof(unsigned int); ++i)
+        bench_ready_count(fillers, __BENCH_READY_COUNTS[i]);
+}
+
+void bench_ready_main()
+{
+    IPC ipc;
+    open_stdout();
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_RUN:
+            bench_ready_run();
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+void bench_ready()
+{
+    HANDLE bench = process_create(&__BENCH_READY);
+    ack(bench, HAL_REQ(HAL_APP, BENCH_RUN), 0, 0, 0);
+    process_destroy(bench);
+}
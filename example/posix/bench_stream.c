@@ -0,0 +1,162 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "bench.h"
+#include "config.h"
+#include "../../userspace/process.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/stdlib.h"
+#include "../../userspace/stream.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+#include "../../userspace/rb.h"
+#include <string.h>
+
+#define BENCH_STREAM_MAX                        4096
+//not aligned to transfer size, so copies are wrapped
+#define BENCH_STREAM_RING_SIZE                  6000
+
+void bench_stream_main();
+
+static const REX __BENCH_STREAM = {
+    //name
+    "Stream bench",
+    //size
+    BENCH_STREAM_PROCESS_SIZE,
+    //priority
+    BENCH_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_stream_main
+};
+
+static const unsigned int __BENCH_STREAM_SIZES[] = {1, 64, 4096};
+
+typedef struct {
+    RB rb;
+    char data[BENCH_STREAM_RING_SIZE];
+    char src[BENCH_STREAM_MAX];
+    char dst[BENCH_STREAM_MAX];
+    HANDLE handle;
+} BENCH_STREAM;
+
+//ring copy, as kernel stream was doing before: byte by byte
+static void bench_stream_bytes(BENCH_STREAM* bench, unsigned int size)
+{
+    unsigned int i;
+    for (i = 0; i < size; ++i)
+        bench->data[rb_put(&bench->rb)] = bench->src[i];
+    for (i = 0; i < size; ++i)
+        bench->dst[i] = bench->data[rb_get(&bench->rb)];
+}
+
+//ring copy in contiguous spans: at most two memcpy per direction
+static void bench_stream_spans(BENCH_STREAM* bench, unsigned int size)
+{
+    unsigned int done, chunk, offset;
+    for (done = 0; done < size; done += chunk)
+    {
+        chunk = size - done;
+        offset = rb_put_span(&bench->rb, &chunk);
+        memcpy(bench->data + offset, bench->src + done, chunk);
+    }
+    for (done = 0; done < size; done += chunk)
+    {
+        chunk = size - done;
+        offset = rb_get_span(&bench->rb, &chunk);
+        memcpy(bench->dst + done, bench->data + offset, chunk);
+    }
+}
+
+//kernel stream: write and read back, never blocked
+static void bench_stream_write_read(BENCH_STREAM* bench, unsigned int size)
+{
+    stream_write_no_block(bench->handle, bench->src, size);
+    stream_read_no_block(bench->handle, bench->dst, size);
+}
+
+//best of few runs: host is preempting us
+static unsigned int bench_stream_ns(BENCH_STREAM* bench, unsigned int size, void (*copy)(BENCH_STREAM*, unsigned int))
+{
+    SYSTIME uptime;
+    unsigned int i, j, us, best;
+    for (j = 0, best = 0; j < BENCH_STREAM_RUNS; ++j)
+    {
+        rb_init(&bench->rb, BENCH_STREAM_RING_SIZE);
+        memset(bench->dst, 0, size);
+        get_uptime(&uptime);
+        for (i = 0; i < BENCH_STREAM_ROUNDS; ++i)
+            copy(bench, size);
+        us = systime_elapsed_us(&uptime);
+        if (j == 0 || us < best)
+            best = us;
+        if (memcmp(bench->src, bench->dst, size))
+            printf("Stream bench: copy failed\n");
+    }
+    return best * 1000 / BENCH_STREAM_ROUNDS;
+}
+
+static void bench_stream_size(BENCH_STREAM* bench, unsigned int size)
+{
+    unsigned int bytes_ns, spans_ns, stream_ns;
+    bytes_ns = bench_stream_ns(bench, size, bench_stream_bytes);
+    spans_ns = bench_stream_ns(bench, size, bench_stream_spans);
+    stream_ns = bench_stream_ns(bench, size, bench_stream_write_read);
+    printf("%6d %8d %8d %10d\n", size, bytes_ns, spans_ns, stream_ns);
+}
+
+static inline void bench_stream_run()
+{
+    BENCH_STREAM* bench;
+    HANDLE stream;
+    int i;
+    bench = malloc(sizeof(BENCH_STREAM));
+    stream = stream_create(BENCH_STREAM_RING_SIZE);
+    if (bench == NULL || stream == INVALID_HANDLE || (bench->handle = stream_open(stream)) == INVALID_HANDLE)
+    {
+        printf("Stream bench: out of memory\n");
+        free(bench);
+        return;
+    }
+    for (i = 0; i < BENCH_STREAM_MAX; ++i)
+        bench->src[i] = (char)i;
+    //per round: put and get whole size
+    printf("  size  byte ns  span ns  stream ns\n");
+    for (i = 0; i < sizeof(__BENCH_STREAM_SIZES) / sizeof(unsigned int); ++i)
+        bench_stream_size(bench, __BENCH_STREAM_SIZES[i]);
+    stream_close(bench->handle);
+    stream_destroy(stream);
+    free(bench);
+}
+
+void bench_stream_main()
+{
+    IPC ipc;
+    open_stdout();
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_RUN:
+            bench_stream_run();
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+void bench_stream()
+{
+    HANDLE bench = process_create(&__BENCH_STREAM);
+    ack(bench, HAL_REQ(HAL_APP, BENCH_RUN), 0, 0, 0);
+    process_destroy(bench);
+}
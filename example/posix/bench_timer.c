@@ -0,0 +1,151 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "bench.h"
+#include "config.h"
+#include "../../userspace/process.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/stdlib.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+#include "../../userspace/sys.h"
+
+#define BENCH_TIMER_MAX                         5000
+//queue is holding all timeouts
+#define BENCH_TIMER_QUEUE_SIZE                  (BENCH_TIMER_MAX + 2)
+//deadlines are in slots, start order is scrambled across them
+#define BENCH_TIMER_SLOTS                       10
+#define BENCH_TIMER_SLOT_US                     20000
+#define BENCH_TIMER_BASE_US                     20000
+
+#define BENCH_TIMER_US(i)                       (BENCH_TIMER_BASE_US + (((i) * 7) % BENCH_TIMER_SLOTS) * BENCH_TIMER_SLOT_US)
+
+void bench_timer_main();
+
+static const REX __BENCH_TIMER = {
+    //name
+    "Timer bench",
+    //size
+    BENCH_TIMER_PROCESS_SIZE,
+    //priority
+    BENCH_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    bench_timer_main,
+    //ipc size
+    BENCH_TIMER_QUEUE_SIZE
+};
+
+static const unsigned int __BENCH_TIMER_COUNTS[] = {10, 100, 1000, 5000};
+
+typedef struct {
+    HANDLE timers[BENCH_TIMER_MAX];
+    SYSTIME deadline[BENCH_TIMER_MAX];
+} BENCH_TIMER;
+
+//timeouts must come in deadline order. Lateness is including host timer wakeup
+static bool bench_timer_expire(BENCH_TIMER* bench, unsigned int count, unsigned int* late_avg, unsigned int* late_max)
+{
+    IPC ipc;
+    SYSTIME time;
+    SYSTIME* prev;
+    unsigned int i, late;
+    bool ordered = true;
+    *late_max = *late_avg = 0;
+    for (i = 0; i < count; ++i)
+    {
+        get_uptime(&bench->deadline[i]);
+        us_to_systime(BENCH_TIMER_US(i), &time);
+        systime_add(&bench->deadline[i], &time, &bench->deadline[i]);
+        timer_start_us(bench->timers[i], BENCH_TIMER_US(i));
+    }
+    for (i = 0, prev = NULL; i < count; ++i)
+    {
+        ipc_read(&ipc);
+        late = systime_elapsed_us(&bench->deadline[ipc.param1]);
+        *late_avg += late;
+        if (late > *late_max)
+            *late_max = late;
+        if (prev != NULL && systime_compare(&bench->deadline[ipc.param1], prev) > 0)
+            ordered = false;
+        prev = &bench->deadline[ipc.param1];
+    }
+    *late_avg /= count;
+    return ordered;
+}
+
+static void bench_timer_count(BENCH_TIMER* bench, unsigned int count)
+{
+    SYSTIME uptime;
+    unsigned int i, start_us, stop_us, late_avg, late_max;
+    bool ordered;
+
+    get_uptime(&uptime);
+    for (i = 0; i < count; ++i)
+        timer_start_us(bench->timers[i], BENCH_TIMER_US(i));
+    start_us = systime_elapsed_us(&uptime);
+
+    get_uptime(&uptime);
+    for (i = 0; i < count; ++i)
+        timer_stop(bench->timers[i], i, HAL_APP);
+    stop_us = systime_elapsed_us(&uptime);
+
+    ordered = bench_timer_expire(bench, count, &late_avg, &late_max);
+    printf("%6d %9d %8d %8d %8d %s\n", count, start_us * 1000 / count, stop_us * 1000 / count, late_avg, late_max,
+           ordered ? "ok" : "FAILED");
+}
+
+static inline void bench_timer_run()
+{
+    BENCH_TIMER* bench;
+    int i;
+    bench = malloc(sizeof(BENCH_TIMER));
+    if (bench == NULL)
+    {
+        printf("Timer bench: out of memory\n");
+        return;
+    }
+    for (i = 0; i < BENCH_TIMER_MAX; ++i)
+        if ((bench->timers[i] = timer_create(i, HAL_APP)) == INVALID_HANDLE)
+        {
+            printf("Timer bench: out of timers\n");
+            return;
+        }
+    printf("timers  start ns  stop ns  late us   max us  order\n");
+    for (i = 0; i < sizeof(__BENCH_TIMER_COUNTS) / sizeof(unsigned int); ++i)
+        bench_timer_count(bench, __BENCH_TIMER_COUNTS[i]);
+    for (i = 0; i < BENCH_TIMER_MAX; ++i)
+        timer_destroy(bench->timers[i]);
+    free(bench);
+}
+
+void bench_timer_main()
+{
+    IPC ipc;
+    open_stdout();
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case BENCH_RUN:
+            bench_timer_run();
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+void bench_timer()
+{
+    HANDLE bench = process_create(&__BENCH_TIMER);
+    ack(bench, HAL_REQ(HAL_APP, BENCH_RUN), 0, 0, 0);
+    process_destroy(bench);
+}
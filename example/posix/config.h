@@ -0,0 +1,54 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+//on host process memory is used only for pool, stacks are host allocated
+#define TCPIP_PROCESS_SIZE                          2048
+#define TCPIP_PROCESS_PRIORITY                      149
+
+#define WEBS_PROCESS_SIZE                           4096
+#define WEBS_PROCESS_PRIORITY                       148
+
+#define VFS_PROCESS_SIZE                            2048
+#define VFS_PROCESS_PRIORITY                        147
+
+#define HTTP_CLIENT_PROCESS_SIZE                    2048
+#define HTTP_CLIENT_PROCESS_PRIORITY                190
+
+#define TEST_ROUNDS                                 10000
+#define ECHO_ROUNDS                                 10000
+#define PING_COUNT                                  3
+
+#define BENCH_PROCESS_SIZE                          2048
+#define BENCH_PROCESS_PRIORITY                      180
+
+#define BENCH_IPC_ROUNDS                            10000
+//pool is holding handles and start time of every timer
+#define BENCH_TIMER_PROCESS_SIZE                    (64 * 1024)
+#define BENCH_READY_ROUNDS                          1000
+#define BENCH_FILLER_PROCESS_SIZE                   512
+#define BENCH_FILLER_PROCESS_PRIORITY               190
+#define BENCH_INVERSION_ROUNDS                      100
+//bench is high, hog is medium, server is low priority
+#define BENCH_HOG_PROCESS_PRIORITY                  185
+#define BENCH_SERVER_PROCESS_PRIORITY               188
+#define BENCH_HOG_US                                2000
+#define BENCH_SERVER_US                             200
+//pool is holding ring and both buffers
+#define BENCH_STREAM_PROCESS_SIZE                   (16 * 1024)
+#define BENCH_STREAM_ROUNDS                         10000
+#define BENCH_STREAM_RUNS                           5
+//pool is holding trace and arena of replayed pool
+#define BENCH_POOL_PROCESS_SIZE                     (192 * 1024)
+#define BENCH_POOL_ARENA_SIZE                       (64 * 1024)
+#define BENCH_POOL_OPS                              20000
+#define BENCH_POOL_RUNS                             5
+#define BENCH_POOL_FRAGMENTATION_OPS                1000000
+#define BENCH_POOL_CHECK_OPS                        4096
+
+#endif // CONFIG_H
@@ -0,0 +1,110 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "disk.h"
+#include "app_private.h"
+#include "config.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/storage.h"
+#include "../../userspace/posix/posix_driver.h"
+#include "posix_config.h"
+#include <string.h>
+
+#define DISK_INDEX_FILE                     "index.htm"
+
+static const char __INDEX[] =               "<html><body>RExOS on POSIX: served by webs from FAT16 on RAM disk</body></html>";
+
+static bool disk_write_file(APP* app, const char* file_path, const char* data, unsigned int size)
+{
+    HANDLE f;
+    int res;
+    IO* io = io_create(size);
+    if (io == NULL)
+        return false;
+    res = -1;
+    f = vfs_open(&app->disk.vfs_record, file_path, VFS_MODE_WRITE);
+    if (f != INVALID_HANDLE)
+    {
+        io_data_write(io, data, size);
+        res = vfs_write_sync(&app->disk.vfs_record, f, io);
+        vfs_close(&app->disk.vfs_record, f);
+    }
+    io_destroy(io);
+    return res == size;
+}
+
+int disk_read_file(APP* app, const char* file_path, IO* io)
+{
+    HANDLE f;
+    int res;
+    if (!app->disk.mounted)
+        return -1;
+    f = vfs_open(&app->disk.vfs_record, file_path, VFS_MODE_READ);
+    if (f == INVALID_HANDLE)
+        return -1;
+    io_reset(io);
+    res = vfs_read_sync(&app->disk.vfs_record, f, io, io_get_free(io));
+    vfs_close(&app->disk.vfs_record, f);
+    return res;
+}
+
+void disk_init(APP* app)
+{
+    HANDLE disk;
+    VFS_VOLUME_TYPE volume;
+    VFS_FAT_FORMAT_TYPE format;
+    IO* io;
+    int res;
+
+    app->disk.mounted = false;
+    app->disk.storage = disk = process_create(&__POSIX_DISK);
+    app->disk.vfs = vfs_create(VFS_PROCESS_SIZE, VFS_PROCESS_PRIORITY);
+    if (!vfs_record_create(app->disk.vfs, &app->disk.vfs_record))
+        return;
+    if (!storage_open(HAL_FLASH, disk, 0))
+        return;
+
+    volume.hal = HAL_FLASH;
+    volume.sector_mode = SECTOR_MODE_DIRECT;
+    volume.process = disk;
+    volume.user = 0;
+    volume.first_sector = 0;
+    volume.sectors_count = POSIX_DISK_SECTORS;
+    if (!vfs_open_volume(&app->disk.vfs_record, &volume))
+    {
+        printf("VFS: open volume failed\n");
+        return;
+    }
+
+    format.root_entries = 32;
+    format.cluster_sectors = 1;
+    format.fat_count = 2;
+    format.serial = 0x12345678;
+    strcpy(format.label, "RAMDISK");
+    if (!vfs_format(&app->disk.vfs_record, &format) || !vfs_open_fs(&app->disk.vfs_record))
+    {
+        printf("VFS: format failed\n");
+        return;
+    }
+    app->disk.mounted = true;
+    if (!disk_write_file(app, DISK_INDEX_FILE, __INDEX, sizeof(__INDEX) - 1))
+    {
+        printf("VFS: write failed\n");
+        return;
+    }
+
+    //round-trip check
+    io = io_create(512);
+    if (io == NULL)
+        return;
+    res = disk_read_file(app, DISK_INDEX_FILE, io);
+    if ((res == sizeof(__INDEX) - 1) && (memcmp(io_data(io), __INDEX, res) == 0))
+        printf("VFS: %s %d bytes, read back ok. Used: %d, free: %d\n", DISK_INDEX_FILE, res,
+               vfs_get_used(&app->disk.vfs_record), vfs_get_free(&app->disk.vfs_record));
+    else
+        printf("VFS: read back failed: %d\n", res);
+    io_destroy(io);
+}
@@ -0,0 +1,24 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef DISK_H
+#define DISK_H
+
+#include "app.h"
+#include "../../userspace/types.h"
+#include "../../userspace/vfs.h"
+
+typedef struct {
+    HANDLE vfs, storage;
+    VFS_RECORD_TYPE vfs_record;
+    bool mounted;
+} DISK;
+
+void disk_init(APP* app);
+//read whole file in io. Returns size or -1
+int disk_read_file(APP* app, const char* file_path, IO* io);
+
+#endif // DISK_H
@@ -0,0 +1,64 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef KERNEL_CONFIG_H
+#define KERNEL_CONFIG_H
+
+//----------------------------------- kernel ------------------------------------------------------------------
+//enable kernel info. Disabling this you can save some flash size, but kernel will be much less verbose, especially on critical errors. Generally doesn't affect on perfomance
+#define KERNEL_DEBUG                                1
+//marks objects with magic in headers. Decrease perfomance on few tacts, but very useful for debug if you don't have MPU enabled
+#define KERNEL_MARKS                                0
+//check range of dynamic objects in pools
+#define KERNEL_RANGE_CHECKING                       0
+//check kernel handles. Require few tacts, but making kernel calls much safer
+#define KERNEL_HANDLE_CHECKING                      1
+//check user adresses. Require few tacts, but making kernel calls much safer
+#define KERNEL_ADDRESS_CHECKING                     0
+//some kernel statistics (stack, mem, etc). Decrease perfomance in any object creation.
+#define KERNEL_PROFILING                            1
+//Enabling this you will get stats on each thread uptime, but decreasing context switching up to 2 times
+#define KERNEL_PROCESS_STAT                         1
+//Kernel halt on fatal error, disable power save mode
+//Don't forget to turn off in production.
+#define KERNEL_DEVELOPER_MODE                       1
+//enable this only if you have problems with system timer. May decrease perfomance
+#define KERNEL_TIMER_DEBUG                          0
+//kernel event tracer: context switch, IPC, wakeup, IRQ, stream and timer events. Number of events in trace buffer.
+//Each event costs 20 bytes of kernel RAM. 0 - disabled
+#define KERNEL_TRACE                                4096
+//number of process priority levels, multiple of 32, up to 1024. Priorities above are scheduled as lowest.
+//Must be above highest distinct priority: drivers and services in tree are using 91..161, application (200) is lowest.
+//Each level costs pointer in kernel RAM: 192 levels - 768 bytes
+#define KERNEL_PRIORITY_LEVELS                      192
+//round-robin time quantum in us for processes of same priority. Timer is armed only while top priority is shared.
+//0 - disabled, process runs until sleep or preemption
+#define KERNEL_TIME_SLICE_US                        0
+//default size of IPC queue per process. Can be overridden by REX.ipc_size
+#define KERNEL_IPC_COUNT                            7
+//enable this only if you have problems with IPC oferflow.
+#define KERNEL_IPC_DEBUG                            1
+//maximum number of global handles. Must be at least 1
+#define KERNEL_OBJECTS_COUNT                        5
+//enable multi-process safe dynamic heap. Required for most of high-level stacks (BLE, TCP/IP, etc)
+//disable to save few bytes
+#define KERNEL_HEAP                                 1
+//max released objects of each type (process, stream, stream handle, soft timer), kept for reuse.
+//0 - disabled, every object is allocated from kernel pool
+#define KERNEL_SLAB                                 0
+//recycle IO objects in size classes 64, 256, 1536, 4096 bytes. Max cached objects per class.
+//Cached objects are kept out of kernel pool: up to N * 6KB. IO is cached only if it's at least half of class size.
+//0 - disabled, every IO is allocated from kernel pool
+#define KERNEL_IO_CACHE                             0
+//two-level segregated fit allocator for kernel pools and processes with REX_FLAG_POOL_TLSF. O(1) malloc/free.
+//Costs about 380 bytes of control block in each pool. 0 - disabled, all pools are first-fit
+#define KERNEL_POOL_TLSF                            1
+//allocation profiling: tag each slot with caller, live and peak bytes per site, size histogram. Number of sites per pool,
+//last one is for all others. Report in process_info and heap_profile (KERNEL_PROFILING required). Resolve addresses with addr2line.
+//Costs pointer in each slot and 16 bytes per site + 32 bytes in each pool. 0 - disabled
+#define KERNEL_ALLOC_PROFILING                      8
+
+#endif // KERNEL_CONFIG_H
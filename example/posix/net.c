@@ -0,0 +1,286 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "net.h"
+#include "app_private.h"
+#include "config.h"
+#include "../../userspace/eth.h"
+#include "../../userspace/ip.h"
+#include "../../userspace/icmp.h"
+#include "../../userspace/tcp.h"
+#include "../../userspace/tcpip.h"
+#include "../../userspace/web.h"
+#include "../../userspace/object.h"
+#include "../../userspace/sys.h"
+#include "../../userspace/stdio.h"
+#include "../../userspace/stdlib.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/posix/posix_driver.h"
+#include "trace_dump.h"
+#include <string.h>
+
+//both ends of virtual wire: webs on server, HTTP client on client
+#define NET_SERVER_PORT                     0
+#define NET_CLIENT_PORT                     1
+#define NET_HTTP_PORT                       80
+#define NET_INDEX_URL                       "/index.htm"
+#define NET_IO_SIZE                         1024
+
+static const MAC __SERVER_MAC =             {{0x20, 0xD9, 0x97, 0xA1, 0x90, 0x42}};
+static const MAC __CLIENT_MAC =             {{0x20, 0xD9, 0x97, 0xA1, 0x90, 0x43}};
+static const IP __SERVER_IP =               {{192, 168, 8, 126}};
+static const IP __CLIENT_IP =               {{192, 168, 8, 1}};
+
+void http_client();
+
+static const REX __HTTP_CLIENT = {
+    //name
+    "HTTP client",
+    //size
+    HTTP_CLIENT_PROCESS_SIZE,
+    //priority
+    HTTP_CLIENT_PROCESS_PRIORITY,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    http_client
+};
+
+//returns body size, or -1 if response is not complete
+static int http_client_body(char* buf, unsigned int size, char** body)
+{
+    char* head_end;
+    char* len;
+    unsigned int i, content_size;
+    buf[size] = '\0';
+    if ((head_end = strstr(buf, "\r\n\r\n")) == NULL)
+        return -1;
+    *body = head_end + 4;
+    if ((len = strstr(buf, "Content-Length: ")) == NULL || len > head_end)
+        return 0;
+    len += 16;
+    for (i = 0; len[i] >= '0' && len[i] <= '9'; ++i) {}
+    content_size = atou(len, i);
+    if (buf + size - *body < content_size)
+        return -1;
+    return content_size;
+}
+
+static int http_client_get(HANDLE tcpip, IO* io, char* buf, unsigned int buf_size)
+{
+    HANDLE tcb;
+    TCP_STACK* tcp_stack;
+    char* body;
+    unsigned int size;
+    int res;
+
+    tcb = tcp_create_tcb(tcpip, &__SERVER_IP, NET_HTTP_PORT);
+    if (tcb == INVALID_HANDLE)
+        return -1;
+    if (!tcp_open(tcpip, tcb))
+    {
+        tcp_close(tcpip, tcb);
+        return -1;
+    }
+    io_reset(io);
+    sprintf(io_data(io), "GET %s HTTP/1.1\r\nHost: %d.%d.%d.%d\r\n\r\n", NET_INDEX_URL,
+            __SERVER_IP.u8[0], __SERVER_IP.u8[1], __SERVER_IP.u8[2], __SERVER_IP.u8[3]);
+    io->data_size = strlen(io_data(io));
+    tcp_stack = io_push(io, sizeof(TCP_STACK));
+    tcp_stack->flags = TCP_PSH;
+    if (tcp_write_sync(tcpip, tcb, io) < 0)
+    {
+        tcp_close(tcpip, tcb);
+        return -1;
+    }
+
+    //collect response, till body is complete
+    for (size = 0, res = -1; res < 0 && size < buf_size; )
+    {
+        io_reset(io);
+        if (tcp_read_sync(tcpip, tcb, io, buf_size - size) <= 0)
+            break;
+        io_pop(io, sizeof(TCP_STACK));
+        memcpy(buf + size, io_data(io), io->data_size);
+        size += io->data_size;
+        res = http_client_body(buf, size, &body);
+    }
+    tcp_close(tcpip, tcb);
+    if (res < 0)
+        return -1;
+    printf("HTTP client: %d bytes\n", size);
+    //status line and body
+    *strstr(buf, "\r\n") = '\0';
+    printf("%s\n%s\n", buf, body);
+    return size;
+}
+
+void http_client()
+{
+    IPC ipc;
+    IO* io;
+    char* buf;
+    SYSTIME uptime;
+    int res;
+    unsigned int us;
+
+    open_stdout();
+    io = io_create(NET_IO_SIZE + sizeof(TCP_STACK));
+    buf = malloc(NET_IO_SIZE + 1);
+    if (io == NULL || buf == NULL)
+    {
+        printf("HTTP client: out of memory\n");
+        return;
+    }
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (HAL_ITEM(ipc.cmd))
+        {
+        case NET_HTTP_GET:
+            get_uptime(&uptime);
+            res = http_client_get((HANDLE)ipc.param1, io, buf, NET_IO_SIZE);
+            us = systime_elapsed_us(&uptime);
+            ipc_post_inline(ipc.process, HAL_CMD(HAL_APP, NET_HTTP_DONE), 0, res, us);
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
+
+static HANDLE net_stack_create(HANDLE eth, unsigned int port, const MAC* mac, const IP* ip, unsigned int priority)
+{
+    HANDLE tcpip;
+    eth_set_mac(eth, port, mac);
+    tcpip = tcpip_create(TCPIP_PROCESS_SIZE, priority, port);
+    if (tcpip == INVALID_HANDLE)
+        return INVALID_HANDLE;
+    ip_set(tcpip, ip);
+    tcpip_open(tcpip, eth, port, ETH_AUTO);
+    return tcpip;
+}
+
+void net_init(APP* app)
+{
+    HANDLE eth;
+    app->net.up = 0;
+    app->net.webs = INVALID_HANDLE;
+    app->net.io = io_create(NET_IO_SIZE);
+    process_create(&__POSIX_ETH);
+    eth = object_get(SYS_OBJ_ETH);
+
+    //different priorities: both stacks are going up at once, debug output is not interleaved
+    app->net.server = net_stack_create(eth, NET_SERVER_PORT, &__SERVER_MAC, &__SERVER_IP, TCPIP_PROCESS_PRIORITY);
+    app->net.client = net_stack_create(eth, NET_CLIENT_PORT, &__CLIENT_MAC, &__CLIENT_IP, TCPIP_PROCESS_PRIORITY + 1);
+    app->net.http_client = process_create(&__HTTP_CLIENT);
+}
+
+static inline void ping_test(APP* app)
+{
+    SYSTIME uptime;
+    int i, success;
+    unsigned int total;
+    success = 0;
+    total = 0;
+    for (i = 0; i < PING_COUNT; ++i)
+    {
+        get_uptime(&uptime);
+        if (icmp_ping(app->net.client, &__SERVER_IP))
+        {
+            total += systime_elapsed_us(&uptime);
+            ++success;
+        }
+    }
+    printf("Ping: %d/%d", success, PING_COUNT);
+    if (success)
+        printf(", average %d us", total / success);
+    printf("\n");
+}
+
+static inline void webs_init(APP* app)
+{
+    HANDLE root;
+    app->net.webs = web_server_create(WEBS_PROCESS_SIZE, WEBS_PROCESS_PRIORITY);
+    if (!web_server_open(app->net.webs, NET_HTTP_PORT, app->net.server))
+    {
+        printf("WEBS: open failed\n");
+        return;
+    }
+    root = web_server_create_node(app->net.webs, WEB_ROOT_NODE, "", 0);
+    web_server_create_node(app->net.webs, root, NET_INDEX_URL + 1, WEB_FLAG(WEB_METHOD_GET));
+}
+
+static inline void ip_up(APP* app)
+{
+    //both ends of wire
+    if (++app->net.up < 2)
+        return;
+    printf("Network interfaces up\n");
+    ping_test(app);
+    webs_init(app);
+    //trace only request
+    trace_dump_reset();
+    ipc_post_inline(app->net.http_client, HAL_CMD(HAL_APP, NET_HTTP_GET), app->net.client, 0, 0);
+}
+
+static inline void ip_request(APP* app, IPC* ipc)
+{
+    switch (HAL_ITEM(ipc->cmd))
+    {
+    case IP_UP:
+        ip_up(app);
+        break;
+    case IP_DOWN:
+        --app->net.up;
+        break;
+    default:
+        error(ERROR_NOT_SUPPORTED);
+        break;
+    }
+}
+
+//serve file from RAM disk
+static inline void webs_get(APP* app, HANDLE session)
+{
+    if (disk_read_file(app, NET_INDEX_URL + 1, app->net.io) < 0)
+    {
+        io_reset(app->net.io);
+        web_server_write_sync(app->net.webs, session, WEB_RESPONSE_NOT_FOUND, app->net.io);
+        return;
+    }
+    web_server_write_sync(app->net.webs, session, WEB_RESPONSE_OK, app->net.io);
+}
+
+static inline void webs_request(APP* app, IPC* ipc)
+{
+    switch (HAL_ITEM(ipc->cmd))
+    {
+    case WEBS_GET:
+        webs_get(app, (HANDLE)ipc->param1);
+        break;
+    default:
+        error(ERROR_NOT_SUPPORTED);
+        break;
+    }
+}
+
+void net_request(APP* app, IPC* ipc)
+{
+    switch (HAL_GROUP(ipc->cmd))
+    {
+    case HAL_IP:
+        ip_request(app, ipc);
+        break;
+    case HAL_WEBS:
+        webs_request(app, ipc);
+        break;
+    default:
+        error(ERROR_NOT_SUPPORTED);
+    }
+}
@@ -0,0 +1,31 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef NET_H
+#define NET_H
+
+#include "app.h"
+#include "../../userspace/types.h"
+#include "../../userspace/ipc.h"
+#include "../../userspace/io.h"
+
+typedef enum {
+    NET_HTTP_GET = IPC_USER,
+    NET_HTTP_DONE
+} NET_IPCS;
+
+typedef struct {
+    //stacks on both ends of virtual wire
+    HANDLE server, client;
+    HANDLE webs, http_client;
+    unsigned int up;
+    IO* io;
+} NET;
+
+void net_init(APP* app);
+void net_request(APP* app, IPC* ipc);
+
+#endif // NET_H
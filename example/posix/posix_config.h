@@ -0,0 +1,23 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef POSIX_CONFIG_H
+#define POSIX_CONFIG_H
+
+//------------------------------ CONSOLE ---------------------------------------------
+//stdout stream, printed by host. Writer is blocked, while stream is full
+#define POSIX_CONSOLE_PROCESS_SIZE              512
+#define POSIX_CONSOLE_STREAM_SIZE               512
+//------------------------------- ETH ------------------------------------------------
+//virtual wire: frame, sent on one port, is received on other
+#define POSIX_ETH_PROCESS_SIZE                  512
+#define POSIX_ETH_PORTS                         2
+//------------------------------- DISK -----------------------------------------------
+//RAM disk, 512 bytes sectors
+#define POSIX_DISK_PROCESS_SIZE                 512
+#define POSIX_DISK_SECTORS                      256
+
+#endif // POSIX_CONFIG_H
@@ -0,0 +1,130 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef SYS_CONFIG_H
+#define SYS_CONFIG_H
+
+/*
+    config.h - userspace config. POSIX host: tcpip, vfss and webs over virtual drivers, see kernel/posix
+ */
+
+//----------------------------- objects ----------------------------------------------
+//make sure, you know what are you doing, before change
+#define SYS_OBJ_STDOUT                                      0
+#define SYS_OBJ_CORE                                        1
+#define SYS_OBJ_ETH                                         2
+
+#define SYS_OBJ_ADC                                         INVALID_HANDLE
+#define SYS_OBJ_DAC                                         INVALID_HANDLE
+#define SYS_OBJ_STDIN                                       INVALID_HANDLE
+//--------------------------------- ETH ----------------------------------------------
+#define ETH_AUTO_NEGOTIATION_TIME                           5000
+
+#define ETH_DOUBLE_BUFFERING                                1
+//------------------------------- TCP/IP ---------------------------------------------
+#define TCPIP_DEBUG                                         1
+#define TCPIP_DEBUG_ERRORS                                  1
+
+#define TCPIP_MTU                                           1500
+#define TCPIP_MAX_FRAMES_COUNT                              10
+
+//----------------------------- TCP/IP MAC --------------------------------------------
+//software MAC filter. Turn on in case of hardware is not supporting
+#define MAC_FILTER                                          0
+#define MAC_FIREWALL                                        1
+#define TCPIP_MAC_DEBUG                                     0
+
+//----------------------------- TCP/IP ARP --------------------------------------------
+#define ARP_DEBUG                                           1
+#define ARP_DEBUG_FLOW                                      0
+
+#define ARP_CACHE_SIZE_MAX                                  10
+//in seconds
+#define ARP_CACHE_INCOMPLETE_TIMEOUT                        5
+#define ARP_CACHE_TIMEOUT                                   600
+
+//----------------------------- TCP/IP IP ---------------------------------------------
+#define IP_DEBUG                                            1
+#define IP_DEBUG_FLOW                                       0
+
+//set, if not supported by hardware
+#define IP_CHECKSUM                                         1
+
+#define IP_FRAGMENTATION                                    1
+#define IP_FRAGMENTATION_ASSEMBLY_TIMEOUT                   10
+//must be less TCPIP_MTU * TCPIP_MAX_FRAMES_COUNT
+#define IP_MAX_LONG_SIZE                                    5000
+#define IP_MAX_LONG_PACKETS                                 2
+
+#define IP_FIREWALL                                         1
+
+//---------------------------- TCP/IP ICMP --------------------------------------------
+#define ICMP                                                1
+#define ICMP_DEBUG                                          1
+
+#define ICMP_ECHO_TIMEOUT                                   5
+//reply on ICMP echo and echo request
+#define ICMP_ECHO                                           1
+
+//----------------------------- TCP/IP UDP --------------------------------------------
+#define UDP                                                 0
+//required for DHCP
+#define UDP_BROADCAST                                       1
+#define DNSS                                                0
+#define DHCPS                                               0
+
+
+#define UDP_DEBUG                                           0
+#define UDP_DEBUG_FLOW                                      0
+#define DNSS_DEBUG                                          1
+#define DHCPS_DEBUG                                         1
+
+//----------------------------- TCP/IP TCP --------------------------------------------
+#define TCP_DEBUG                                           1
+#define TCP_RETRY_COUNT                                     3
+#define TCP_KEEP_ALIVE                                      0
+#define TCP_TIMEOUT                                         30000
+//0 - don't limit
+#define TCP_HANDLES_LIMIT                                   10
+//Low-level debug. only for development
+#define TCP_DEBUG_FLOW                                      0
+#define TCP_DEBUG_PACKETS                                   0
+
+//----------------------------- web server---------------------------------------------
+#define WEBS_DEBUG_ERRORS                                   1
+#define WEBS_DEBUG_SESSION                                  1
+#define WEBS_DEBUG_REQUESTS                                 1
+#define WEBS_DEBUG_FLOW                                     0
+
+#define WEBS_MAX_SESSIONS                                   2
+//0 means close connection immediatly
+#define WEBS_SESSION_TIMEOUT_S                              3
+
+//Each session internal IO size. Smaller may require more often requests
+//to TCP/IP stack, bigger consumes more memory. Default to MSS.
+#define WEBS_IO_SIZE                                        1460
+//Maximum request size. If request is bigger, it will be responded with "payload too large"
+#define WEBS_MAX_PAYLOAD                                    8192
+
+//---------------------------------- VFS ----------------------------------------------
+#define VFS_DEBUG_INFO                                      1
+#define VFS_DEBUG_ERRORS                                    1
+#define VFS_MAX_FILE_PATH                                   256
+#define VFS_MAX_HANDLES                                     5
+//enable BER support
+#define VFS_BER                                             1
+#define VFS_BER_DEBUG_INFO                                  1
+#define VFS_BER_DEBUG_ERRORS                                1
+
+//align data sectors by cluster start offset (recommended to enable for flash storage)
+#define VFS_CLUSTER_ALIGN                                   1
+//update modify/access time (recommended to disable for flash storage)
+#define VFS_FILE_ATTRIBUTES_UPDATE                          0
+
+//01.09.2016 as default if not rtc used
+#define VFS_BASE_DATE                                       736207
+
+#endif // SYS_CONFIG_H
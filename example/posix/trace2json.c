@@ -0,0 +1,207 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+/*
+    Host tool: kernel trace, printed by trace_dump(), to Chrome trace/Perfetto JSON.
+    Other lines of output are skipped, decoder is exiting on end of dump, so it can be piped:
+    build/rexos_posix | build/trace2json > build/trace.json
+    Open in ui.perfetto.dev or chrome://tracing.
+
+    Every process is thread track, running slices are from context switches. IPC post is flow arrow from sender
+    to next slice of receiver, so request is followed across servers. IRQs are on separate track.
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "../../userspace/trace.h"
+
+#define TRACE2JSON_MAX_PROCESSES                256
+#define TRACE2JSON_NAME_SIZE                    64
+#define TRACE2JSON_LINE_SIZE                    256
+#define TRACE2JSON_PID                          1
+//IRQ and kernel timers track
+#define TRACE2JSON_IRQ_TID                      0
+
+typedef struct {
+    unsigned int handle;
+    char name[TRACE2JSON_NAME_SIZE];
+    //IPC flow, waiting for next slice of process. 0 - none
+    unsigned int flow;
+} TRACE2JSON_PROCESS;
+
+typedef struct {
+    TRACE2JSON_PROCESS processes[TRACE2JSON_MAX_PROCESSES];
+    unsigned int processes_count;
+    unsigned long long start;
+    unsigned long long running_since;
+    int running;
+    unsigned int flows;
+    bool first;
+} TRACE2JSON;
+
+static const char* const __TRACE_EVENTS[] = {"switch", "ipc post", "ipc wait", "wakeup", "irq enter", "irq exit",
+                                             "stream block", "stream unblock", "timer", "lost"};
+
+//thread id is process index + 1
+static int trace2json_process(TRACE2JSON* t, unsigned int handle)
+{
+    unsigned int i;
+    for (i = 0; i < t->processes_count; ++i)
+        if (t->processes[i].handle == handle)
+            return i;
+    if (t->processes_count >= TRACE2JSON_MAX_PROCESSES)
+        return -1;
+    t->processes[i].handle = handle;
+    if (handle == KERNEL_HANDLE)
+        strcpy(t->processes[i].name, "Kernel");
+    else
+        sprintf(t->processes[i].name, "0x%08x", handle);
+    t->processes[i].flow = 0;
+    return t->processes_count++;
+}
+
+static void trace2json_event(TRACE2JSON* t, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+static void trace2json_event(TRACE2JSON* t, const char* fmt, ...)
+{
+    va_list va;
+    printf(t->first ? "\n  " : ",\n  ");
+    t->first = false;
+    va_start(va, fmt);
+    vprintf(fmt, va);
+    va_end(va);
+}
+
+static void trace2json_names(TRACE2JSON* t)
+{
+    unsigned int i;
+    trace2json_event(t, "{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_name\",\"args\":{\"name\":\"RExOS\"}}", TRACE2JSON_PID);
+    trace2json_event(t, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"IRQ\"}}",
+                     TRACE2JSON_PID, TRACE2JSON_IRQ_TID);
+    for (i = 0; i < t->processes_count; ++i)
+        trace2json_event(t, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                         TRACE2JSON_PID, i + 1, t->processes[i].name);
+}
+
+static void trace2json_instant(TRACE2JSON* t, unsigned long long ts, int tid, TRACE* e)
+{
+    trace2json_event(t, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"name\":\"%s\","
+                     "\"args\":{\"param1\":\"0x%08x\",\"param2\":\"0x%08x\"}}",
+                     TRACE2JSON_PID, tid, ts, __TRACE_EVENTS[e->event], e->param1, e->param2);
+}
+
+static void trace2json_switch(TRACE2JSON* t, unsigned long long ts, int next)
+{
+    TRACE2JSON_PROCESS* p;
+    if (t->running >= 0)
+    {
+        p = &t->processes[t->running];
+        trace2json_event(t, "{\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"dur\":%llu,\"name\":\"%s\"}",
+                         TRACE2JSON_PID, t->running + 1, t->running_since, ts - t->running_since, p->name);
+    }
+    t->running = next;
+    t->running_since = ts;
+    if (next < 0)
+        return;
+    //finish IPC flow on slice of receiver
+    p = &t->processes[next];
+    if (p->flow)
+    {
+        trace2json_event(t, "{\"ph\":\"f\",\"bp\":\"e\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"id\":%u,\"name\":\"ipc\",\"cat\":\"ipc\"}",
+                         TRACE2JSON_PID, next + 1, ts, p->flow);
+        p->flow = 0;
+    }
+}
+
+static void trace2json_post(TRACE2JSON* t, unsigned long long ts, int sender, int receiver)
+{
+    TRACE2JSON_PROCESS* p;
+    //posted by kernel or IRQ
+    if (receiver < 0 || sender < 0)
+        return;
+    p = &t->processes[receiver];
+    //first not received post is on critical path
+    if (p->flow)
+        return;
+    p->flow = ++t->flows;
+    trace2json_event(t, "{\"ph\":\"s\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"id\":%u,\"name\":\"ipc\",\"cat\":\"ipc\"}",
+                     TRACE2JSON_PID, sender + 1, ts, p->flow);
+}
+
+static void trace2json_decode(TRACE2JSON* t, unsigned long long ts, TRACE* e)
+{
+    int tid;
+    switch (e->event)
+    {
+    case TRACE_SWITCH:
+        trace2json_switch(t, ts, trace2json_process(t, e->param1));
+        break;
+    case TRACE_IPC_POST:
+        trace2json_post(t, ts, trace2json_process(t, e->param1), trace2json_process(t, e->param2));
+        trace2json_instant(t, ts, trace2json_process(t, e->param1) + 1, e);
+        break;
+    case TRACE_IPC_WAIT:
+    case TRACE_WAKEUP:
+    case TRACE_STREAM_BLOCK:
+    case TRACE_STREAM_UNBLOCK:
+        tid = trace2json_process(t, e->param1);
+        trace2json_instant(t, ts, tid < 0 ? TRACE2JSON_IRQ_TID : tid + 1, e);
+        break;
+    case TRACE_IRQ_ENTER:
+    case TRACE_IRQ_EXIT:
+        trace2json_event(t, "{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%llu,\"name\":\"IRQ %u\"}",
+                         e->event == TRACE_IRQ_ENTER ? 'B' : 'E', TRACE2JSON_PID, TRACE2JSON_IRQ_TID, ts, e->param1);
+        break;
+    case TRACE_TIMER:
+    case TRACE_LOST:
+        trace2json_instant(t, ts, TRACE2JSON_IRQ_TID, e);
+        break;
+    default:
+        fprintf(stderr, "trace2json: unknown event %u\n", e->event);
+        break;
+    }
+}
+
+int main()
+{
+    static TRACE2JSON t;
+    char line[TRACE2JSON_LINE_SIZE];
+    char name[TRACE2JSON_NAME_SIZE];
+    unsigned long long ts = 0;
+    unsigned int handle, events;
+    TRACE e;
+    int i;
+
+    t.running = -1;
+    t.first = true;
+    events = 0;
+    printf("{\"traceEvents\":[");
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        if (sscanf(line, "TRACE N %x %63[^\n]", &handle, name) == 2)
+        {
+            if ((i = trace2json_process(&t, handle)) >= 0)
+                strcpy(t.processes[i].name, name);
+        }
+        else if (sscanf(line, "TRACE E %u %u %u %x %x", &e.time.sec, &e.time.usec, &e.event, &e.param1, &e.param2) == 5)
+        {
+            ts = (unsigned long long)e.time.sec * 1000000ull + e.time.usec;
+            if (events++ == 0)
+                t.start = ts;
+            trace2json_decode(&t, ts - t.start, &e);
+        }
+        else if (strncmp(line, "TRACE END", 9) == 0)
+            break;
+    }
+    //close last slice
+    if (events)
+        trace2json_switch(&t, ts - t.start, -1);
+    trace2json_names(&t);
+    printf("\n]}\n");
+    fprintf(stderr, "trace2json: %u events, %u processes, %u IPC flows\n", events, t.processes_count, t.flows);
+    return 0;
+}
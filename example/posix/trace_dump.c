@@ -0,0 +1,38 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "trace_dump.h"
+#include "../../userspace/trace.h"
+#include "../../userspace/stdio.h"
+
+#define TRACE_DUMP_CHUNK                        8
+
+void trace_dump_reset()
+{
+    TRACE buf[TRACE_DUMP_CHUNK];
+    unsigned int count, readed;
+    for (count = trace_count(); count; count -= readed)
+        if ((readed = trace_read(buf, count > TRACE_DUMP_CHUNK ? TRACE_DUMP_CHUNK : count)) == 0)
+            break;
+}
+
+void trace_dump(const TRACE_DUMP_NAME* names, unsigned int names_count)
+{
+    TRACE buf[TRACE_DUMP_CHUNK];
+    unsigned int i, count, total, readed;
+    //printing is producing new events itself. Dump only already recorded
+    count = trace_count();
+    for (i = 0; i < names_count; ++i)
+        printf("TRACE N %x %s\n", names[i].process, names[i].name);
+    for (total = 0; total < count; total += readed)
+    {
+        if ((readed = trace_read(buf, count - total > TRACE_DUMP_CHUNK ? TRACE_DUMP_CHUNK : count - total)) == 0)
+            break;
+        for (i = 0; i < readed; ++i)
+            printf("TRACE E %d %d %d %x %x\n", buf[i].time.sec, buf[i].time.usec, buf[i].event, buf[i].param1, buf[i].param2);
+    }
+    printf("TRACE END %d\n", total);
+}
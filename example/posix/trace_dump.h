@@ -0,0 +1,30 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef TRACE_DUMP_H
+#define TRACE_DUMP_H
+
+/*
+    Kernel trace, printed to stdout as text lines for host decoder:
+    TRACE N <handle> <name>                             process name
+    TRACE E <sec> <usec> <event> <param1> <param2>      event, handles and params are hex
+    TRACE END <count>                                   end of dump
+    Decoder (trace2json) is converting it to Chrome trace/Perfetto JSON.
+*/
+
+#include "../../userspace/types.h"
+
+typedef struct {
+    HANDLE process;
+    const char* name;
+} TRACE_DUMP_NAME;
+
+//drop events, recorded before call
+void trace_dump_reset();
+//print names and events, recorded before call
+void trace_dump(const TRACE_DUMP_NAME* names, unsigned int names_count);
+
+#endif // TRACE_DUMP_H
@@ -0,0 +1,204 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "kposix.h"
+#include "kposix_host.h"
+#include "kernel_config.h"
+#include "../kernel.h"
+#include "../kprocess.h"
+#include "../kirq.h"
+#include "../ksystime.h"
+#include "../dbg.h"
+#include "../../userspace/systime.h"
+#include "../../userspace/error.h"
+
+extern void kprocess_abnormal_exit();
+
+//host link map stub. __GLOBAL and __KERNEL are on start of SRAM
+unsigned int __posix_sram[SRAM_SIZE / sizeof(unsigned int)] __attribute__ ((aligned(8)));
+
+//running kernel code. svc_call from kernel/irq is direct
+static int __posix_kernel =                         0;
+//switch pended by kernel
+static int __posix_switch =                         0;
+//running host context
+static void* __posix_context =                      NULL;
+//context of destroyed process. Released after switch, we are still running on it
+static void* __posix_zombie =                       NULL;
+static KIRQ __posix_irqs[KPOSIX_IRQ_COUNT];
+
+static void kposix_second_pulse_isr(int vector, void* param)
+{
+    systime_second_pulse();
+}
+
+static void kposix_hpet_isr(int vector, void* param)
+{
+    systime_hpet_timeout();
+}
+
+static void kposix_hpet_start(unsigned int us, void* param)
+{
+    kposix_host_hpet_start(us);
+}
+
+static void kposix_hpet_stop(void* param)
+{
+    kposix_host_hpet_stop();
+}
+
+static unsigned int kposix_hpet_elapsed(void* param)
+{
+    return kposix_host_hpet_elapsed();
+}
+
+static const CB_SVC_TIMER __KPOSIX_HPET = {kposix_hpet_start, kposix_hpet_stop, kposix_hpet_elapsed};
+
+static void kposix_stdout(const char *const buf, unsigned int size, void* param)
+{
+    kposix_host_stdout(buf, size);
+}
+
+static void kposix_release_zombie()
+{
+    if (__posix_zombie != NULL)
+    {
+        kposix_host_context_destroy(__posix_zombie);
+        __posix_zombie = NULL;
+    }
+}
+
+//irqs, pended by host timer thread
+static void kposix_irq()
+{
+    int vector;
+    unsigned int pending = kposix_host_pending();
+    for (vector = 0; pending; ++vector, pending >>= 1)
+        if (pending & 1)
+            kirq_enter(vector);
+}
+
+static void kposix_switch()
+{
+    KPROCESS* to;
+    void* from = __posix_context;
+    //halt core till irq if no tasks
+    while ((to = __KERNEL->next_process) == NULL)
+    {
+        kposix_host_idle();
+        kposix_irq();
+    }
+    __posix_switch = 0;
+    __KERNEL->next_process = NULL;
+    __GLOBAL->process = to->process;
+    __posix_context = *(void**)to->sp;
+    //active_process will be NULL on startup/task destroy. Nothing to save
+    if (__KERNEL->active_process == NULL)
+        from = NULL;
+    __KERNEL->active_process = to;
+    //switch to self is saving and restoring context too, like PendSV on target
+    kposix_host_context_switch(from, __posix_context);
+    kposix_release_zombie();
+}
+
+static void kposix_kernel_exit()
+{
+    kposix_irq();
+    if (__posix_switch)
+        kposix_switch();
+    __posix_kernel = 0;
+}
+
+static void kposix_entry(unsigned int fn)
+{
+    kposix_release_zombie();
+    //finish kernel exit, started by previous process
+    kposix_kernel_exit();
+    ((void (*)(void))fn)();
+    __posix_kernel = 1;
+    kprocess_abnormal_exit();
+    kposix_kernel_exit();
+}
+
+void pend_switch_context(void)
+{
+    __posix_switch = 1;
+}
+
+void process_setup_context(KPROCESS* process, void (*fn)(void))
+{
+    void* ctx = kposix_host_context_create(kposix_entry, (unsigned int)fn);
+    if (ctx == NULL)
+    {
+#if (KERNEL_DEBUG)
+        printk("POSIX: out of host memory\n");
+#endif
+        panic();
+    }
+    //context is saved on top of process stack, so pool will never grow over it
+    process->sp = (unsigned int*)(((unsigned int)process->sp & ~(sizeof(void*) - 1)) - sizeof(void*));
+    *(void**)process->sp = ctx;
+}
+
+void process_destroy_context(KPROCESS* process)
+{
+    void* ctx = *(void**)process->sp;
+    if (ctx == __posix_context)
+        __posix_zombie = ctx;
+    else
+        kposix_host_context_destroy(ctx);
+}
+
+void svc_call(unsigned int num, unsigned int param1, unsigned int param2, unsigned int param3)
+{
+    //called from kernel or irq
+    if (__posix_kernel)
+    {
+        svc(num, param1, param2, param3);
+        return;
+    }
+    __posix_kernel = 1;
+    svc(num, param1, param2, param3);
+    kposix_kernel_exit();
+}
+
+void* get_sp()
+{
+    //kernel pool is limited by SRAM end, process pool by context on top of process memory
+    if (__posix_kernel || __KERNEL->active_process == NULL)
+        return (void*)(SRAM_BASE + SRAM_SIZE);
+    return ((KPROCESS*)__KERNEL->active_process)->sp;
+}
+
+//core thread
+static void kposix_main()
+{
+    int i;
+    __posix_kernel = 1;
+    startup();
+    kernel_setup_dbg(kposix_stdout, NULL);
+
+    __posix_irqs[KPOSIX_IRQ_SECOND_PULSE].handler = kposix_second_pulse_isr;
+    __posix_irqs[KPOSIX_IRQ_HPET].handler = kposix_hpet_isr;
+    for (i = 0; i < KPOSIX_IRQ_COUNT; ++i)
+    {
+        __posix_irqs[i].error = ERROR_OK;
+        __posix_irqs[i].param = NULL;
+        __posix_irqs[i].process = KERNEL_HANDLE;
+        __KERNEL->irqs[i] = &__posix_irqs[i];
+    }
+    ksystime_hpet_setup(&__KPOSIX_HPET, NULL);
+    kposix_host_second_pulse_start();
+
+    //run application process. Never returns
+    kposix_kernel_exit();
+}
+
+int main()
+{
+    kposix_host_run(kposix_main, KPOSIX_IRQ_HPET, KPOSIX_IRQ_SECOND_PULSE);
+    return 0;
+}
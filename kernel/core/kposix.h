@@ -0,0 +1,51 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef KPOSIX_H
+#define KPOSIX_H
+
+/*
+    kposix.h - POSIX host port. Whole system is running as single host process for simulation, profiling and benchmarking.
+
+    - SRAM is static host array, all kernel and process memory is allocated from it
+    - kernel and all processes are running on single host core thread, every process on own host stack (ucontext),
+      process memory is used only for pool
+    - host timers (timerfd) are running on main thread as HPET and second pulse. Expiration is pended as IRQ and core
+      is waked up by pipe. No host signals are used
+    - core is not preemptible: pended IRQs are served on every kernel exit (svc) and in idle, so process, running
+      without svc calls, is delaying IRQs
+
+    Kernel is casting pointers to unsigned int, so reference build is 32 bit (-m32 -DPOSIX). 64 bit build is possible
+    only if all RExOS memory is in low 4GB: non-PIE (-fno-pie -no-pie), host stacks are checked on allocation.
+    kposix_host.c must be compiled without RExOS include folders, link with -lpthread. See example/posix
+*/
+
+#include "../../userspace/cc_macro.h"
+#include "../kprocess_private.h"
+
+//host timers irq vectors
+#define KPOSIX_IRQ_SECOND_PULSE             0
+#define KPOSIX_IRQ_HPET                     1
+#define KPOSIX_IRQ_COUNT                    2
+
+__STATIC_INLINE void fatal()
+{
+    __builtin_abort();
+}
+
+//core is not preemptible on host, irqs are pended by host timer thread
+__STATIC_INLINE void disable_interrupts(void)
+{
+}
+
+__STATIC_INLINE void enable_interrupts(void)
+{
+}
+
+//host stack is not part of process memory, so it must be released separately
+void process_destroy_context(KPROCESS* process);
+
+#endif // KPOSIX_H
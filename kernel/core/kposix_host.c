@@ -0,0 +1,232 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#define _GNU_SOURCE
+#include "kposix_host.h"
+#include <ucontext.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+
+#define KPOSIX_HOST_STACK_SIZE              (64 * 1024)
+#define KPOSIX_HOST_CORE_STACK_SIZE         (256 * 1024)
+
+//kernel is casting pointers to unsigned int, so on 64 bit host every stack must be in low 4GB
+#ifndef MAP_32BIT
+#define MAP_32BIT                           0
+#endif
+
+typedef struct {
+    ucontext_t uc;
+    unsigned char stack[KPOSIX_HOST_STACK_SIZE];
+} KPOSIX_HOST_CONTEXT;
+
+//hpet re-arm and timer thread are serialized, so stopped timer is never pended
+static pthread_mutex_t __posix_host_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile unsigned int __posix_host_pending = 0;
+static int __posix_host_hpet, __posix_host_second, __posix_host_hpet_vector, __posix_host_second_vector;
+//core wakeup
+static int __posix_host_wake[2];
+static struct timespec __posix_host_hpet_start, __posix_host_hpet_deadline;
+static bool __posix_host_hpet_armed = false;
+static void (*__posix_host_core)(void);
+
+static void kposix_host_fatal(const char* msg)
+{
+    write(STDERR_FILENO, msg, strlen(msg));
+    abort();
+}
+
+static void* kposix_host_alloc(size_t size)
+{
+    void* res = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (res == MAP_FAILED)
+        return NULL;
+    //pointer will be truncated by kernel
+    if ((uint64_t)(uintptr_t)res + size > 0x100000000ull)
+        kposix_host_fatal("POSIX: host memory is out of low 4GB\n");
+    return res;
+}
+
+static void kposix_host_wakeup()
+{
+    char c = 0;
+    //pipe is full, core will wakeup anyway
+    write(__posix_host_wake[1], &c, 1);
+}
+
+//called under lock
+static void kposix_host_timer_check(int fd, int vector)
+{
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+    {
+        __sync_fetch_and_or(&__posix_host_pending, 1u << vector);
+        kposix_host_wakeup();
+    }
+}
+
+//called under lock. Forget expiration, not processed yet, and re-arm. Must be in this order: short value can
+//expire before drain and will be lost
+static void kposix_host_timer_reset(int fd, int vector, int flags, const struct itimerspec* it)
+{
+    uint64_t expirations;
+    read(fd, &expirations, sizeof(expirations));
+    __sync_fetch_and_and(&__posix_host_pending, ~(1u << vector));
+    timerfd_settime(fd, flags, it, NULL);
+}
+
+static void* kposix_host_core_thread(void* param)
+{
+    __posix_host_core();
+    return NULL;
+}
+
+void kposix_host_run(void (*core)(void), int hpet_vector, int second_pulse_vector)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct pollfd fds[2];
+    void* stack;
+    __posix_host_core = core;
+    __posix_host_hpet_vector = hpet_vector;
+    __posix_host_second_vector = second_pulse_vector;
+    __posix_host_hpet = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    __posix_host_second = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (__posix_host_hpet < 0 || __posix_host_second < 0 || pipe2(__posix_host_wake, O_NONBLOCK) < 0)
+        kposix_host_fatal("POSIX: host timers setup failed\n");
+    if ((stack = kposix_host_alloc(KPOSIX_HOST_CORE_STACK_SIZE)) == NULL)
+        kposix_host_fatal("POSIX: out of host memory\n");
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, KPOSIX_HOST_CORE_STACK_SIZE);
+    if (pthread_create(&thread, &attr, kposix_host_core_thread, NULL))
+        kposix_host_fatal("POSIX: core thread create failed\n");
+
+    //host timers are running here, core is only waked up
+    fds[0].fd = __posix_host_hpet;
+    fds[1].fd = __posix_host_second;
+    fds[0].events = fds[1].events = POLLIN;
+    for (;;)
+    {
+        if (poll(fds, 2, -1) <= 0)
+            continue;
+        pthread_mutex_lock(&__posix_host_lock);
+        kposix_host_timer_check(__posix_host_hpet, __posix_host_hpet_vector);
+        kposix_host_timer_check(__posix_host_second, __posix_host_second_vector);
+        pthread_mutex_unlock(&__posix_host_lock);
+    }
+}
+
+void kposix_host_stdout(const char *const buf, unsigned int size)
+{
+    write(STDOUT_FILENO, buf, size);
+}
+
+unsigned int kposix_host_pending()
+{
+    return __sync_fetch_and_and(&__posix_host_pending, 0);
+}
+
+void kposix_host_idle()
+{
+    struct pollfd fd;
+    char buf[64];
+    fd.fd = __posix_host_wake[0];
+    fd.events = POLLIN;
+    //pended after last check. Wakeup byte is already in pipe
+    while (__posix_host_pending == 0)
+        poll(&fd, 1, -1);
+    while (read(__posix_host_wake[0], buf, sizeof(buf)) > 0) {}
+}
+
+void* kposix_host_context_create(void (*entry)(unsigned int), unsigned int param)
+{
+    KPOSIX_HOST_CONTEXT* ctx = kposix_host_alloc(sizeof(KPOSIX_HOST_CONTEXT));
+    if (ctx == NULL)
+        return NULL;
+    getcontext(&ctx->uc);
+    ctx->uc.uc_stack.ss_sp = ctx->stack;
+    ctx->uc.uc_stack.ss_size = KPOSIX_HOST_STACK_SIZE;
+    ctx->uc.uc_link = NULL;
+    makecontext(&ctx->uc, (void (*)(void))entry, 1, param);
+    return ctx;
+}
+
+void kposix_host_context_destroy(void* ctx)
+{
+    munmap(ctx, sizeof(KPOSIX_HOST_CONTEXT));
+}
+
+void kposix_host_context_switch(void* from, void* to)
+{
+    if (from == NULL)
+        setcontext(&((KPOSIX_HOST_CONTEXT*)to)->uc);
+    else
+        swapcontext(&((KPOSIX_HOST_CONTEXT*)from)->uc, &((KPOSIX_HOST_CONTEXT*)to)->uc);
+}
+
+static inline bool kposix_host_time_passed(const struct timespec* time, const struct timespec* now)
+{
+    return time->tv_sec < now->tv_sec || (time->tv_sec == now->tv_sec && time->tv_nsec <= now->tv_nsec);
+}
+
+void kposix_host_hpet_start(unsigned int us)
+{
+    struct itimerspec it = {{0, 0}, {0, 0}};
+    struct timespec now;
+    pthread_mutex_lock(&__posix_host_lock);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    //restarted after expiration, like from timeout ISR. Hardware counter is not waiting for ISR, so count from
+    //expiration, not from now. Else every ISR latency on host is lost for uptime
+    if (__posix_host_hpet_armed && kposix_host_time_passed(&__posix_host_hpet_deadline, &now))
+        __posix_host_hpet_start = __posix_host_hpet_deadline;
+    else
+        __posix_host_hpet_start = now;
+    __posix_host_hpet_deadline.tv_sec = __posix_host_hpet_start.tv_sec + us / 1000000;
+    __posix_host_hpet_deadline.tv_nsec = __posix_host_hpet_start.tv_nsec + (us % 1000000) * 1000;
+    if (__posix_host_hpet_deadline.tv_nsec >= 1000000000)
+    {
+        ++__posix_host_hpet_deadline.tv_sec;
+        __posix_host_hpet_deadline.tv_nsec -= 1000000000;
+    }
+    __posix_host_hpet_armed = true;
+    //absolute time in past is expiring right now. Zero value is disarming timer
+    it.it_value = __posix_host_hpet_deadline;
+    if (it.it_value.tv_sec == 0 && it.it_value.tv_nsec == 0)
+        it.it_value.tv_nsec = 1;
+    kposix_host_timer_reset(__posix_host_hpet, __posix_host_hpet_vector, TFD_TIMER_ABSTIME, &it);
+    pthread_mutex_unlock(&__posix_host_lock);
+}
+
+void kposix_host_hpet_stop()
+{
+    struct itimerspec it = {{0, 0}, {0, 0}};
+    pthread_mutex_lock(&__posix_host_lock);
+    __posix_host_hpet_armed = false;
+    kposix_host_timer_reset(__posix_host_hpet, __posix_host_hpet_vector, 0, &it);
+    pthread_mutex_unlock(&__posix_host_lock);
+}
+
+unsigned int kposix_host_hpet_elapsed()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - __posix_host_hpet_start.tv_sec) * 1000000 + (now.tv_nsec - __posix_host_hpet_start.tv_nsec) / 1000;
+}
+
+void kposix_host_second_pulse_start()
+{
+    struct itimerspec it = {{1, 0}, {1, 0}};
+    timerfd_settime(__posix_host_second, 0, &it, NULL);
+}
@@ -0,0 +1,33 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef KPOSIX_HOST_H
+#define KPOSIX_HOST_H
+
+/*
+    kposix_host.h - host side of POSIX port. Implemented on libc only, without RExOS headers, cause of names conflict
+    (sleep, malloc, time.h, etc). Must be compiled without RExOS include folders.
+*/
+
+//create core thread and run host timers on calling thread. Never returns
+void kposix_host_run(void (*core)(void), int hpet_vector, int second_pulse_vector);
+void kposix_host_stdout(const char *const buf, unsigned int size);
+//mask of pending irq vectors. Cleared on read
+unsigned int kposix_host_pending();
+//halt core till any irq
+void kposix_host_idle();
+
+void* kposix_host_context_create(void (*entry)(unsigned int), unsigned int param);
+void kposix_host_context_destroy(void* ctx);
+//if from is NULL, nothing to save
+void kposix_host_context_switch(void* from, void* to);
+
+void kposix_host_hpet_start(unsigned int us);
+void kposix_host_hpet_stop();
+unsigned int kposix_host_hpet_elapsed();
+void kposix_host_second_pulse_start();
+
+#endif // KPOSIX_HOST_H
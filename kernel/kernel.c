@@ -16,6 +16,7 @@
 #include "ksystime.h"
 #include "kstdlib.h"
 #include "kheap.h"
+#include "ktrace.h"
 
 #include "../userspace/error.h"
 #include "../userspace/core/core.h"
@@ -59,6 +60,8 @@ void kernel_setup_dbg(STDOUT stdout, void* param)
 void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned int param3)
 {
     HANDLE process = kprocess_get_current();
+    //all wakeups are coalesced, ready top is picked once on exit
+    kprocess_lock_schedule();
     switch (num)
     {
     //process related
@@ -99,6 +102,26 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
         kprocess_info();
         break;
 #endif //KERNEL_PROFILING
+#if (KERNEL_PROCESS_STAT)
+    case SVC_PROCESS_GET_STAT:
+        CHECK_ADDRESS(process, (PROCESS_STAT*)param2, sizeof(PROCESS_STAT));
+        kprocess_get_stat((HANDLE)param1, (PROCESS_STAT*)param2);
+        break;
+#endif //KERNEL_PROCESS_STAT
+#if (KERNEL_TRACE)
+    case SVC_TRACE_READ:
+        CHECK_ADDRESS(process, (TRACE*)param1, param2 * sizeof(TRACE));
+        CHECK_ADDRESS(process, (unsigned int*)param3, sizeof(unsigned int));
+        *((unsigned int*)param3) = ktrace_read((TRACE*)param1, param2);
+        break;
+    case SVC_TRACE_COUNT:
+        CHECK_ADDRESS(process, (unsigned int*)param1, sizeof(unsigned int));
+        *((unsigned int*)param1) = ktrace_count();
+        break;
+    case SVC_TRACE_LOST:
+        ktrace_lost(param1);
+        break;
+#endif //KERNEL_TRACE
     //irq related
     case SVC_IRQ_REGISTER:
         kirq_register(process, (int)param1, (IRQ)param2, (void*)param3);
@@ -128,7 +151,11 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
         break;
     case SVC_SYSTIME_SOFT_TIMER_START:
         CHECK_ADDRESS(process, (SYSTIME*)param2, sizeof(SYSTIME));
-        ksystime_soft_timer_start((HANDLE)param1, (SYSTIME*)param2);
+        ksystime_soft_timer_start_slack((HANDLE)param1, (SYSTIME*)param2, param3);
+        break;
+    case SVC_SYSTIME_SOFT_TIMER_START_PERIODIC:
+        CHECK_ADDRESS(process, (SYSTIME*)param2, sizeof(SYSTIME));
+        ksystime_soft_timer_start_periodic((HANDLE)param1, (SYSTIME*)param2);
         break;
     case SVC_SYSTIME_SOFT_TIMER_STOP:
         ksystime_soft_timer_stop((HANDLE)param1);
@@ -150,6 +177,14 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
         CHECK_IO_ADDRESS(process, (IPC*)param1);
         kipc_call(process, (IPC*)param1);
         break;
+    case SVC_IPC_POST_BATCH:
+        CHECK_ADDRESS(process, (IPC*)param1, param2 * sizeof(IPC));
+        CHECK_ADDRESS(process, (unsigned int*)param3, sizeof(unsigned int));
+        *((unsigned int*)param3) = kipc_post_batch(process, (IPC*)param1, param2);
+        break;
+    case SVC_IPC_UNBLOCK:
+        kipc_unblock(process);
+        break;
     //stream related
     case SVC_STREAM_CREATE:
         CHECK_ADDRESS(process, (HANDLE*)param1, sizeof(HANDLE));
@@ -176,6 +211,9 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
     case SVC_STREAM_STOP_LISTEN:
         kstream_stop_listen(process, param1);
         break;
+    case SVC_STREAM_LISTEN_WATERMARK:
+        kstream_listen_watermark(process, param1, param2, param3);
+        break;
     case SVC_STREAM_WRITE_NO_BLOCK:
         CHECK_ADDRESS(process, (unsigned int*)param3, sizeof(unsigned int));
         CHECK_ADDRESS(process, (char*)param2, *((unsigned int*)param3));
@@ -200,6 +238,22 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
     case SVC_STREAM_DESTROY:
         kstream_destroy(param1);
         break;
+    case SVC_STREAM_ACQUIRE_READ:
+        CHECK_ADDRESS(process, (char**)param2, sizeof(char*));
+        CHECK_ADDRESS(process, (unsigned int*)param3, sizeof(unsigned int));
+        *((unsigned int*)param3) = kstream_acquire_read(process, param1, (char**)param2);
+        break;
+    case SVC_STREAM_RELEASE_READ:
+        kstream_release_read(process, param1, param2);
+        break;
+    case SVC_STREAM_ACQUIRE_WRITE:
+        CHECK_ADDRESS(process, (char**)param2, sizeof(char*));
+        CHECK_ADDRESS(process, (unsigned int*)param3, sizeof(unsigned int));
+        *((unsigned int*)param3) = kstream_acquire_write(process, param1, (char**)param2);
+        break;
+    case SVC_STREAM_RELEASE_WRITE:
+        kstream_release_write(process, param1, param2);
+        break;
     case SVC_IO_CREATE:
         CHECK_ADDRESS(process, (IO**)param1, sizeof(IO*));
         *((IO**)param1) = kio_create(param2);
@@ -207,6 +261,9 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
     case SVC_IO_DESTROY:
         kio_destroy((IO*)param1);
         break;
+    case SVC_IO_SHARE:
+        kio_share((IO*)param1, (bool)param2);
+        break;
     case SVC_OBJECT_SET:
         kobject_set(process, param1, (HANDLE)param2);
         break;
@@ -229,6 +286,11 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
     case SVC_HEAP_FREE:
         kheap_free((void*)param1);
         break;
+#if (KERNEL_PROFILING) && (KERNEL_ALLOC_PROFILING)
+    case SVC_HEAP_PROFILE:
+        kheap_profile((HANDLE)param1);
+        break;
+#endif //(KERNEL_PROFILING) && (KERNEL_ALLOC_PROFILING)
 #endif //KERNEL_HEAP
     //other - dbg, stdout/in
     case SVC_ADD_POOL:
@@ -250,6 +312,7 @@ void svc(unsigned int num, unsigned int param1, unsigned int param2, unsigned in
     default:
         error(ERROR_INVALID_SVC);
     }
+    kprocess_unlock_schedule();
 }
 
 void startup()
@@ -271,6 +334,17 @@ void startup()
     //initilize system time
     ksystime_init();
 
+    //initialize kernel objects caches
+    kstream_init();
+#if (KERNEL_IO_CACHE)
+    kio_init();
+#endif //KERNEL_IO_CACHE
+
+#if (KERNEL_TRACE)
+    //initialize event tracer
+    ktrace_init();
+#endif //KERNEL_TRACE
+
     //initialize kernel objects
     kobject_init();
 
@@ -44,6 +44,7 @@
 #include "../lib/pool.h"
 #include "../userspace/rb.h"
 #include "../userspace/array.h"
+#include "../userspace/trace.h"
 
 #ifndef IRQ_VECTORS_COUNT
 #error IRQ_VECTORS_COUNT is not decoded. Please specify it manually in Makefile
@@ -53,6 +54,8 @@
 #include "core/arm7/core_arm7.h"
 #elif defined(CORTEX_M)
 #include "kcortexm.h"
+#elif defined(POSIX)
+#include "kposix.h"
 #else
 #error MCU core is not defined or not supported
 #endif
@@ -67,10 +70,17 @@ typedef struct {
     //next process to run, after leave. For context switch. If NULL - no context switch is required
     void* next_process;
 
-    //active processes
-    KPROCESS* processes;
+    //active processes. Head of highest priority queue is running
+    KREADY ready;
+    //reschedule is delayed while locked
+    int schedule_lock;
+    bool schedule_pending;
+    //process, core was last switched to. NULL - core is halted. Active process is kept while halted
+    KPROCESS* scheduled;
 #if (KERNEL_PROCESS_STAT)
     KPROCESS* wait_processes;
+    //process, last switched to
+    KPROCESS* stat_process;
 #endif //(KERNEL_PROCESS_STAT)
     //----------------------- printk support ---------------------------
     STDOUT stdout;
@@ -97,13 +107,34 @@ typedef struct {
     //callback param for HPET timer
     void* cb_ktimer_param;
 
-    KTIMER* timers;
+    //timing wheel
+    KTIMER* timers[KTIMER_USEC_BUCKETS];
+    unsigned int timers_map;
+    KTIMER* timers_sec[KTIMER_SEC_BUCKETS];
+#if (KERNEL_TIME_SLICE_US)
+    //round-robin quantum for processes of same priority
+    KTIMER slice;
+#endif //KERNEL_TIME_SLICE_US
     //HPET value, set before call
     unsigned int hpet_value;
     //--------------------------- memory pools -------------------------
     ARRAY* pools;
+    KSLAB slabs[KSLAB_MAX];
+#if (KERNEL_IO_CACHE)
+    KSLAB io_cache[KIO_CACHE_CLASSES];
+#endif //KERNEL_IO_CACHE
+#if (KERNEL_ALLOC_PROFILING)
+    //caller of kmalloc/krealloc
+    void* alloc_caller;
+#endif //KERNEL_ALLOC_PROFILING
     //-------------------------- kernel objects ------------------------
     HANDLE objects[KERNEL_OBJECTS_COUNT];
+#if (KERNEL_TRACE)
+    //--------------------------- event tracer -------------------------
+    RB trace_rb;
+    unsigned int trace_lost;
+    TRACE trace[KERNEL_TRACE];
+#endif //KERNEL_TRACE
 } KERNEL;
 
 #define __KERNEL                                            ((KERNEL*)(KERNEL_BASE))
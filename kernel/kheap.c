@@ -58,6 +58,11 @@ void* kheap_malloc(HANDLE h, unsigned int size)
     KHEAP* kheap = (KHEAP*)h;
     CHECK_MAGIC(kheap, MAGIC_HEAP);
 
+#if (KERNEL_ALLOC_PROFILING)
+    //caller is passed by userspace heap_malloc in process pool
+    kheap->pool.caller = ((KPROCESS*)kprocess_get_current())->process->pool.caller;
+    ((KPROCESS*)kprocess_get_current())->process->pool.caller = NULL;
+#endif //KERNEL_ALLOC_PROFILING
     ptr = pool_malloc(&kheap->pool, size + sizeof(KHEAP*), kheap->virtual_sp);
     if (ptr == NULL)
         return NULL;
@@ -116,4 +121,14 @@ bool kheap_check(HANDLE h)
 
     return pool_check(&kheap->pool, kheap->virtual_sp);
 }
+
+#if (KERNEL_ALLOC_PROFILING)
+void kheap_profile(HANDLE h)
+{
+    KHEAP* kheap = (KHEAP*)h;
+    CHECK_MAGIC(kheap, MAGIC_HEAP);
+
+    kpool_profile("heap", &kheap->pool, kheap->virtual_sp);
+}
+#endif //KERNEL_ALLOC_PROFILING
 #endif //KERNEL_PROFILING
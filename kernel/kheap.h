@@ -18,5 +18,6 @@ void kheap_free(void* ptr);
 
 void kheap_send(void* ptr, HANDLE process);
 bool kheap_check(HANDLE h);
+void kheap_profile(HANDLE h);
 
 #endif // KHEAP_H
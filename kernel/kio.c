@@ -8,6 +8,8 @@
 #include "kprocess.h"
 #include "kstdlib.h"
 #include "kernel_config.h"
+#include "kernel.h"
+#include "kslab.h"
 
 typedef struct {
     DLIST list;
@@ -16,35 +18,185 @@ typedef struct {
     HANDLE owner;
     HANDLE granted;
     bool kill_flag;
+    //shared read-only IO. Owner keeps it, receivers are holding grants
+    bool shared;
+    unsigned int granted_count;
+    //receivers of shared IO. Free slot is INVALID_HANDLE, same process can hold more than one grant
+    HANDLE holders[KIO_SHARED_HOLDERS];
+    //cache size class, -1 if not cached
+    int size_class;
 }KIO;
 
+//IO is co-allocated right after KIO
+static void kio_ctor(void* obj)
+{
+    KIO* kio = (KIO*)obj;
+    kio->io = (IO*)((unsigned int)kio + sizeof(KIO));
+    kio->io->kio = (HANDLE)kio;
+}
+
+#if (KERNEL_IO_CACHE)
+static const unsigned int __KIO_CLASS_SIZE[KIO_CACHE_CLASSES] =     {64, 256, 1536, 4096};
+
+static int kio_size_class(unsigned int size)
+{
+    int i;
+    for (i = 0; i < KIO_CACHE_CLASSES; ++i)
+        if (size <= __KIO_CLASS_SIZE[i])
+        {
+            //far below class size. Rounding will waste more than half, allocate exact size from pool
+            if (i > 0 && size * 2 < __KIO_CLASS_SIZE[i])
+                return -1;
+            return i;
+        }
+    return -1;
+}
+
+void kio_init()
+{
+    int i;
+    for (i = 0; i < KIO_CACHE_CLASSES; ++i)
+        kslab_init(&__KERNEL->io_cache[i], sizeof(KIO) + sizeof(IO) + __KIO_CLASS_SIZE[i], KERNEL_IO_CACHE, kio_ctor, KSLAB_MAGIC(KIO, MAGIC_KIO));
+}
+#endif //KERNEL_IO_CACHE
+
 static void kio_destroy_internal(KIO* kio)
 {
+#if (KERNEL_IO_CACHE)
+    if (kio->size_class >= 0)
+    {
+        kslab_free(&__KERNEL->io_cache[kio->size_class], kio);
+        return;
+    }
+#endif //KERNEL_IO_CACHE
     CLEAR_MAGIC(kio);
-    kfree(kio->io);
     kfree(kio);
 }
 
 IO* kio_create(unsigned int size)
 {
-    KIO* kio;
+    KIO* kio = NULL;
+    int size_class = -1;
     HANDLE process = kprocess_get_current();
-    kio = (KIO*)kmalloc(sizeof(KIO));
-    if (kio != NULL)
+#if (KERNEL_IO_CACHE)
+    size_class = kio_size_class(size);
+    if (size_class >= 0)
     {
+        //allocate full class size, so object can be recycled for any size in class
+        size = __KIO_CLASS_SIZE[size_class];
+        if ((kio = (KIO*)kslab_alloc(&__KERNEL->io_cache[size_class])) == NULL)
+            return NULL;
+    }
+#endif //KERNEL_IO_CACHE
+    if (kio == NULL)
+    {
+        //KIO and IO are co-allocated
+        if ((kio = (KIO*)kmalloc(sizeof(KIO) + sizeof(IO) + size)) == NULL)
+            return NULL;
         DO_MAGIC(kio, MAGIC_KIO);
-        kio->owner = kio->granted = process;
-        kio->kill_flag = false;
-        kio->io = (IO*)kmalloc(size + sizeof(IO));
-        if ((kio->io) == NULL)
+        kio_ctor(kio);
+    }
+    kio->owner = kio->granted = process;
+    kio->kill_flag = kio->shared = false;
+    kio->granted_count = 0;
+    kio->size_class = size_class;
+    kio->io->size = size + sizeof(IO);
+    return kio->io;
+}
+
+//fragments are not visible for receivers without chain support. Copy them to IO data
+static bool kio_linearize(KIO* kio, HANDLE process, HANDLE receiver)
+{
+#if (KERNEL_ADDRESS_CHECKING)
+    unsigned int i;
+    IO_FRAGMENT* fragment;
+#endif //KERNEL_ADDRESS_CHECKING
+    if (kio->io->chain_size == 0 || receiver == kio->owner || kprocess_io_chain(receiver))
+        return true;
+#if (KERNEL_ADDRESS_CHECKING)
+    //fragments are provided by sender, kernel is copying on it's behalf
+    for (i = 0; i < kio->io->chain_size; ++i)
+    {
+        fragment = io_chain_fragment(kio->io, i);
+        CHECK_ADDRESS(process, fragment->ptr, fragment->len);
+    }
+#endif //KERNEL_ADDRESS_CHECKING
+    if (!io_linearize(kio->io))
+    {
+        error(ERROR_IO_BUFFER_TOO_SMALL);
+        return false;
+    }
+    return true;
+}
+
+static int kio_holder(KIO* kio, HANDLE process)
+{
+    int i;
+    for (i = 0; i < KIO_SHARED_HOLDERS; ++i)
+        if (kio->holders[i] == process)
+            return i;
+    return -1;
+}
+
+static bool kio_send_shared(KIO* kio, HANDLE process, HANDLE receiver)
+{
+    bool destroy = false;
+    int holder;
+    //receiver without chain support. Shared IO is read-only once granted, so linearize only on first send
+    if (kio->io->chain_size && (receiver != kio->owner) && !kprocess_io_chain(receiver))
+    {
+        if ((process != kio->owner) || kio->granted_count)
         {
-            kfree(kio);
-            return NULL;
+            error(ERROR_NOT_SUPPORTED);
+            return false;
         }
-        kio->io->kio = (HANDLE)kio;
-        kio->io->size = size + sizeof(IO);
+        if (!kio_linearize(kio, process, receiver))
+            return false;
     }
-    return kio->io;
+    disable_interrupts();
+    if (process == kio->owner)
+    {
+        if (receiver == kio->owner)
+        {
+            enable_interrupts();
+            return true;
+        }
+        //new grant
+        holder = kio_holder(kio, INVALID_HANDLE);
+        if (holder < 0)
+        {
+            enable_interrupts();
+            error(ERROR_TOO_MANY_HANDLES);
+            return false;
+        }
+        kio->holders[holder] = receiver;
+        ++kio->granted_count;
+    }
+    else
+    {
+        //only grant holder can forward or return IO
+        holder = kio_holder(kio, process);
+        if (holder < 0)
+        {
+            enable_interrupts();
+            error(ERROR_ACCESS_DENIED);
+            return false;
+        }
+        if (receiver == kio->owner)
+        {
+            kio->holders[holder] = INVALID_HANDLE;
+            --kio->granted_count;
+            destroy = kio->kill_flag && (kio->granted_count == 0);
+        }
+        //forwarded by receiver, grant is moved
+        else
+            kio->holders[holder] = receiver;
+    }
+    enable_interrupts();
+    //last receiver released IO
+    if (destroy)
+        kio_destroy_internal(kio);
+    return true;
 }
 
 bool kio_send(HANDLE process, IO* io, HANDLE receiver)
@@ -52,6 +204,8 @@ bool kio_send(HANDLE process, IO* io, HANDLE receiver)
     KIO* kio = (KIO*)(io->kio);
     //sent from untrusted environment
     CHECK_MAGIC(kio, MAGIC_KIO);
+    if (kio->shared)
+        return kio_send_shared(kio, process, receiver);
     if (process != kio->granted)
     {
         error(ERROR_ACCESS_DENIED);
@@ -63,6 +217,8 @@ bool kio_send(HANDLE process, IO* io, HANDLE receiver)
         kio_destroy_internal(kio);
         return true;
     }
+    if (!kio_linearize(kio, process, receiver))
+        return false;
     kio->granted = receiver;
     return true;
 }
@@ -81,7 +237,7 @@ void kio_destroy(IO *io)
         return;
     }
     disable_interrupts();
-    if (kio->granted != kio->owner)
+    if ((kio->granted != kio->owner) || kio->granted_count)
     {
         kio->kill_flag = true;
         kill_flag = true;
@@ -92,3 +248,29 @@ void kio_destroy(IO *io)
     else
         kio_destroy_internal(kio);
 }
+
+void kio_share(IO* io, bool share)
+{
+    bool busy;
+    int i;
+    KIO* kio = (KIO*)io->kio;
+    CHECK_MAGIC(kio, MAGIC_KIO);
+
+    if (kio->owner != kprocess_get_current())
+    {
+        error(ERROR_ACCESS_DENIED);
+        return;
+    }
+    //mode can't be changed while IO is granted
+    disable_interrupts();
+    busy = (kio->granted != kio->owner) || kio->granted_count;
+    if (!busy)
+    {
+        kio->shared = share;
+        for (i = 0; i < KIO_SHARED_HOLDERS; ++i)
+            kio->holders[i] = INVALID_HANDLE;
+    }
+    enable_interrupts();
+    if (busy)
+        error(ERROR_BUSY);
+}
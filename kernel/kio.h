@@ -16,8 +16,14 @@
 
 IO* kio_create(unsigned int size);
 void kio_destroy(IO* io);
+void kio_share(IO* io, bool share);
 
 //internally called from kipc
 bool kio_send(HANDLE process, IO* io, HANDLE receiver);
 
+#if (KERNEL_IO_CACHE)
+//called from kernel
+void kio_init();
+#endif //KERNEL_IO_CACHE
+
 #endif // KIO_H
@@ -9,25 +9,70 @@
 #include "kio.h"
 #include "kprocess.h"
 #include "kheap.h"
+#include "ktrace.h"
 #include "kprocess_private.h"
 #include "../userspace/error.h"
 #include "../userspace/rb.h"
 #include "../userspace/core/core.h"
 #include "kernel.h"
 #include "kernel_config.h"
+#include <string.h>
 
 #define KIPC_ITEM(p, num)                               ((IPC*)((unsigned int)(((KPROCESS*)(p))->process) + sizeof(PROCESS) + (num) * sizeof(IPC)))
 
-void kipc_init(KPROCESS *process)
+void kipc_init(KPROCESS *process, unsigned int size, bool block)
 {
-    rb_init(&(process->process->ipcs), KERNEL_IPC_COUNT);
+    rb_init(&(process->process->ipcs), size);
+    memset(&(process->process->ipcs_filter), 0, sizeof(IPC_FILTER));
+    process->process->ipcs_blocked = false;
     process->kipc.wait_process = INVALID_HANDLE;
     process->kipc.cmd = ANY_CMD;
+    process->kipc.block = block;
+    process->kipc.max = 0;
+    process->kipc.blocked.process = process;
+    process->kipc.senders = NULL;
 }
 
+//called while IRQ disabled
 void kipc_lock_release(KPROCESS* process)
 {
+    KPROCESS* receiver = (KPROCESS*)process->sync_object;
     process->kipc.wait_process = INVALID_HANDLE;
+    //blocked on full queue of receiver
+    if (process->sync_object != INVALID_HANDLE)
+    {
+        dlist_remove((DLIST**)&receiver->kipc.senders, (DLIST*)&process->kipc.blocked);
+        receiver->process->ipcs_blocked = (receiver->kipc.senders != NULL);
+    }
+}
+
+//called while IRQ disabled
+void kipc_destroy(KPROCESS* process)
+{
+    KPROCESS* sender;
+    while (process->kipc.senders)
+    {
+        sender = process->kipc.senders->process;
+        dlist_remove_head((DLIST**)&process->kipc.senders);
+        kprocess_error((HANDLE)sender, ERROR_SYNC_OBJECT_DESTROYED);
+        kprocess_wakeup((HANDLE)sender);
+    }
+}
+
+void kipc_unblock(HANDLE process)
+{
+    KPROCESS* receiver = (KPROCESS*)process;
+    KPROCESS* sender;
+    disable_interrupts();
+    //one item is taken from queue, one sender can repeat post
+    if (receiver->kipc.senders)
+    {
+        sender = receiver->kipc.senders->process;
+        dlist_remove_head((DLIST**)&receiver->kipc.senders);
+        kprocess_wakeup((HANDLE)sender);
+    }
+    receiver->process->ipcs_blocked = (receiver->kipc.senders != NULL);
+    enable_interrupts();
 }
 
 static inline int kipc_index(HANDLE p, HANDLE wait_process, unsigned int cmd, unsigned int param1)
@@ -36,6 +81,9 @@ static inline int kipc_index(HANDLE p, HANDLE wait_process, unsigned int cmd, un
     int i;
     unsigned int head;
     process = (KPROCESS*)p;
+    //not on queue for sure
+    if (!ipc_filter_present(&process->process->ipcs_filter, process->process->ipcs.size, wait_process, cmd))
+        return -1;
     head = process->process->ipcs.head;
     for (i = process->process->ipcs.tail; i != head; i = RB_ROUND(&process->process->ipcs, i + 1))
         if (((KIPC_ITEM(process, i)->process == wait_process) || (wait_process == ANY_HANDLE)) && ((KIPC_ITEM(process, i)->cmd == cmd) || (cmd == ANY_CMD)) &&
@@ -44,6 +92,18 @@ static inline int kipc_index(HANDLE p, HANDLE wait_process, unsigned int cmd, un
     return -1;
 }
 
+bool kipc_queued(HANDLE process, HANDLE sender, unsigned int cmd, unsigned int param1, unsigned int param2)
+{
+    KPROCESS* p = (KPROCESS*)process;
+    int i;
+    unsigned int head = p->process->ipcs.head;
+    for (i = kipc_index(process, sender, cmd, param1); i >= 0 && i != head; i = RB_ROUND(&p->process->ipcs, i + 1))
+        if (KIPC_ITEM(p, i)->process == sender && KIPC_ITEM(p, i)->cmd == cmd && KIPC_ITEM(p, i)->param1 == param1 &&
+            KIPC_ITEM(p, i)->param2 == param2)
+            return true;
+    return false;
+}
+
 static bool kipc_send(HANDLE sender, HANDLE receiver, unsigned int cmd, void* param)
 {
     bool res = true;
@@ -68,22 +128,31 @@ static void kipc_post_internal(HANDLE sender, HANDLE receiver, unsigned int cmd,
     IPC* cur;
     KPROCESS* r;
     int index;
+    unsigned int used;
     index = -1;
     r = (KPROCESS*)receiver;
     disable_interrupts();
     if (!rb_is_full(&r->process->ipcs))
-        index = rb_put(&r->process->ipcs);
-    enable_interrupts();
-    if (index >= 0)
     {
+        index = rb_put(&r->process->ipcs);
         cur = KIPC_ITEM(r, index);
         cur->cmd = cmd;
         cur->param1 = param1;
         cur->param2 = param2;
         cur->param3 = param3;
         cur->process = sender;
+        ++r->process->ipcs_filter.posted[ipc_filter_hash(sender, cmd)];
+        used = r->process->ipcs.head >= r->process->ipcs.tail ? r->process->ipcs.head - r->process->ipcs.tail :
+                                                                 r->process->ipcs.head + r->process->ipcs.size - r->process->ipcs.tail;
+        if (used > r->kipc.max)
+            r->kipc.max = used;
+        KTRACE_INTERNAL(TRACE_IPC_POST, sender, receiver);
+#if (KERNEL_PROCESS_STAT)
+        ++r->stat.ipcs;
+#endif //KERNEL_PROCESS_STAT
     }
-    else
+    enable_interrupts();
+    if (index < 0)
     {
         error(ERROR_OVERFLOW);
 #if (KERNEL_IPC_DEBUG)
@@ -101,18 +170,48 @@ static void kipc_post_internal(HANDLE sender, HANDLE receiver, unsigned int cmd,
     }
 }
 
-void kipc_post(HANDLE sender, IPC* ipc)
+static bool kipc_blocked(HANDLE sender, KPROCESS* receiver)
+{
+    if (!receiver->kipc.block || (sender == (HANDLE)receiver) || !rb_is_full(&receiver->process->ipcs))
+        return false;
+    error(ERROR_BUSY);
+    //IRQ and kernel can't wait
+    if ((sender != KERNEL_HANDLE) && (__KERNEL->context < 0))
+    {
+        kprocess_sleep(sender, NULL, PROCESS_SYNC_IPC, (HANDLE)receiver);
+        disable_interrupts();
+        dlist_add_tail((DLIST**)&receiver->kipc.senders, (DLIST*)&((KPROCESS*)sender)->kipc.blocked);
+        receiver->process->ipcs_blocked = true;
+        enable_interrupts();
+    }
+    return true;
+}
+
+//return true, if sender must not wait for response: receiver is running in our place, or ipc is not posted on full queue
+static bool kipc_deliver(HANDLE sender, IPC* ipc, bool call)
 {
     KPROCESS* receiver;
+    KPROCESS* caller;
+    bool handoff = false;
+    bool reply;
+    unsigned int io_size = 0;
     CHECK_MAGIC((KPROCESS*)ipc->process, MAGIC_PROCESS);
 
+    //full queue in blocking mode. Sender will repeat after wakeup
+    if ((ipc->process != KERNEL_HANDLE) && kipc_blocked(sender, (KPROCESS*)ipc->process))
+        return true;
+    if ((ipc->cmd & HAL_MODE) == HAL_IO_MODE)
+        io_size = ((IO*)ipc->param2)->data_size;
     if (!kipc_send(sender, ipc->process, ipc->cmd, (void*)ipc->param2))
     {
         //can't be delivered. Return response back with error (if required)
         if (ipc->cmd & HAL_REQ_FLAG)
             kipc_post_internal(ipc->process, sender, ipc->cmd & ~HAL_REQ_FLAG, ipc->param1, ipc->param2, get_last_error());
-        return;
+        return false;
     }
+    //IO chain is linearized for receiver. Data size, passed by io_write/io_complete, is grown
+    if (((ipc->cmd & HAL_MODE) == HAL_IO_MODE) && (ipc->param3 == io_size))
+        ipc->param3 = ((IO*)ipc->param2)->data_size;
 #ifdef EXODRIVERS
     if (ipc->process == KERNEL_HANDLE)
     {
@@ -129,11 +228,12 @@ void kipc_post(HANDLE sender, IPC* ipc)
                 ipc->param3 = get_last_error();
             kipc_post_internal(ipc->process, sender, ipc->cmd & ~HAL_REQ_FLAG, ipc->param1, ipc->param2, ipc->param3);
         }
-        return;
+        return false;
     }
 #endif //EXODRIVERS
 
     receiver = (KPROCESS*)ipc->process;
+    caller = (KPROCESS*)sender;
     disable_interrupts();
     if ((receiver->kipc.wait_process == sender || receiver->kipc.wait_process == ANY_HANDLE) &&
                  (receiver->kipc.cmd == ipc->cmd || receiver->kipc.cmd == ANY_CMD) &&
@@ -141,10 +241,53 @@ void kipc_post(HANDLE sender, IPC* ipc)
     {
         //already waiting? Wakeup him
         receiver->kipc.wait_process = INVALID_HANDLE;
-        kprocess_wakeup((HANDLE)receiver);
+        //synchronous call to waiting receiver. Rendezvous: switch directly to receiver
+        if (call && (ipc->cmd & HAL_REQ_FLAG) && (receiver != caller) && ((receiver->flags & PROCESS_MODE_MASK) == PROCESS_MODE_WAITING) &&
+                (kipc_index(sender, ipc->process, ipc->cmd & ~HAL_REQ_FLAG, ipc->param1) < 0))
+        {
+            caller->kipc.wait_process = ipc->process;
+            caller->kipc.cmd = ipc->cmd & ~HAL_REQ_FLAG;
+            caller->kipc.param1 = ipc->param1;
+            kprocess_release_priority((HANDLE)receiver);
+            kprocess_handoff((HANDLE)receiver, sender);
+            handoff = true;
+        }
+        else
+        {
+            //reply to synchronous call? Return CPU directly to caller
+            reply = (receiver->server == caller);
+            //call is complete, return inherited priority
+            kprocess_release_priority((HANDLE)receiver);
+            if (reply)
+                kprocess_wakeup_handoff((HANDLE)receiver);
+            else
+                kprocess_wakeup((HANDLE)receiver);
+        }
     }
     enable_interrupts();
     kipc_post_internal(sender, ipc->process, ipc->cmd, ipc->param1, ipc->param2, ipc->param3);
+    return handoff;
+}
+
+void kipc_post(HANDLE sender, IPC* ipc)
+{
+    kipc_deliver(sender, ipc, false);
+}
+
+unsigned int kipc_post_batch(HANDLE sender, IPC* ipcs, unsigned int count)
+{
+    unsigned int i;
+    //reschedule once, after all receivers are waked up
+    kprocess_lock_schedule();
+    for (i = 0; i < count; ++i)
+    {
+        CHECK_IO_ADDRESS(sender, &ipcs[i]);
+        //blocked on full queue, rest will be posted after wakeup
+        if (kipc_deliver(sender, &ipcs[i], false))
+            break;
+    }
+    kprocess_unlock_schedule();
+    return i;
 }
 
 void kipc_post_exo(HANDLE process, unsigned int cmd, unsigned int param1, unsigned int param2, unsigned int param3)
@@ -176,6 +319,7 @@ void kipc_wait(HANDLE process, HANDLE wait_process, unsigned int cmd, unsigned i
         kprocess_wakeup(process);
     else
     {
+        KTRACE_INTERNAL(TRACE_IPC_WAIT, process, wait_process);
         ((KPROCESS*)process)->kipc.wait_process = wait_process;
         ((KPROCESS*)process)->kipc.cmd = cmd;
         ((KPROCESS*)process)->kipc.param1 = param1;
@@ -186,6 +330,13 @@ void kipc_wait(HANDLE process, HANDLE wait_process, unsigned int cmd, unsigned i
 
 void kipc_call(HANDLE process, IPC* ipc)
 {
-    kipc_post(process, ipc);
+    //receiver was waiting for us and is already running in our place, or we are blocked
+    if (kipc_deliver(process, ipc, true))
+        return;
     kipc_wait(process, ipc->process, ipc->cmd & ~HAL_REQ_FLAG, ipc->param1);
+    //waiting for response? Server inherits our priority until reply
+    disable_interrupts();
+    if ((ipc->cmd & HAL_REQ_FLAG) && (ipc->process != KERNEL_HANDLE) && (((KPROCESS*)process)->kipc.wait_process == ipc->process))
+        kprocess_inherit_priority(ipc->process, process);
+    enable_interrupts();
 }
@@ -11,12 +11,17 @@
 #include "kprocess.h"
 
 //called from kprocess
-void kipc_init(KPROCESS* process);
+void kipc_init(KPROCESS* process, unsigned int size, bool block);
 void kipc_lock_release(KPROCESS* process);
+void kipc_destroy(KPROCESS* process);
 
 void kipc_post(HANDLE sender, IPC* ipc);
 void kipc_post_exo(HANDLE process, unsigned int cmd, unsigned int param1, unsigned int param2, unsigned int param3);
 void kipc_wait(HANDLE process, HANDLE wait_process, unsigned int cmd, unsigned int param1);
 void kipc_call(HANDLE process, IPC* ipc);
+unsigned int kipc_post_batch(HANDLE sender, IPC* ipcs, unsigned int count);
+void kipc_unblock(HANDLE process);
+//called while IRQ disabled. Posted, but not received yet
+bool kipc_queued(HANDLE process, HANDLE sender, unsigned int cmd, unsigned int param1, unsigned int param2);
 
 #endif // KIPC_H
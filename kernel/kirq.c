@@ -8,6 +8,8 @@
 #include "kernel.h"
 #include "kstdlib.h"
 #include "kprocess_private.h"
+#include "kprocess.h"
+#include "ktrace.h"
 #include "../userspace/error.h"
 
 
@@ -56,13 +58,17 @@ void kirq_enter(int vector)
 #endif
     register int saved_context = __KERNEL->context;
     register PROCESS* saved_process = __GLOBAL->process;
+    //wakeups from handlers are coalesced, ready top is picked once on exit
+    kprocess_lock_schedule();
 #ifdef SOFT_NVIC
     while (pending--)
     {
 #endif
         __KERNEL->context = vector;
         __GLOBAL->process = (PROCESS*)__KERNEL->irqs[vector];
+        KTRACE(TRACE_IRQ_ENTER, vector, 0);
         __KERNEL->irqs[vector]->handler(vector, __KERNEL->irqs[vector]->param);
+        KTRACE(TRACE_IRQ_EXIT, vector, 0);
 #ifdef SOFT_NVIC
         if (pending)
         {
@@ -76,6 +82,7 @@ void kirq_enter(int vector)
 #endif
     __KERNEL->context = saved_context;
     __GLOBAL->process = saved_process;
+    kprocess_unlock_schedule();
 }
 
 void kirq_register(HANDLE owner, int vector, IRQ handler, void* param)
@@ -11,8 +11,10 @@
 #include "string.h"
 #include "kstream.h"
 #include "kio.h"
+#include "kslab.h"
 #include "kernel.h"
 #include "ksystime.h"
+#include "ktrace.h"
 #if (KERNEL_BD)
 #include "kdirect.h"
 #endif //KERNEL_BD
@@ -23,81 +25,284 @@
 
 #if (KERNEL_PROFILING)
 #if (KERNEL_PROCESS_STAT)
-const char *const STAT_LINE="-------------------------------------------------------------------------\n";
+const char *const STAT_LINE="-----------------------------------------------------------------------------------\n";
 #else
-const char *const STAT_LINE="---------------------------------------------------------------\n";
+const char *const STAT_LINE="------------------------------------------------------------------------\n";
 #endif
 const char *const DAMAGED="     !!!DAMAGED!!!     ";
 #endif //(KERNEL_PROFILING)
 
+#if (KERNEL_PROCESS_STAT)
+static inline unsigned int kprocess_stat_bucket(unsigned int us)
+{
+    unsigned int bucket = us ? 32 - __builtin_clz(us) : 0;
+    return bucket < PROCESS_STAT_LATENCY_BUCKETS ? bucket : PROCESS_STAT_LATENCY_BUCKETS - 1;
+}
+#endif //KERNEL_PROCESS_STAT
+
+static inline void kprocess_stat_switch(KPROCESS* kprocess)
+{
+#if (KERNEL_PROCESS_STAT)
+    SYSTIME time, run;
+    KPROCESS* prev = __KERNEL->stat_process;
+    if (kprocess == prev)
+        return;
+    ksystime_get_uptime_internal(&time);
+    if (prev != NULL)
+    {
+        ++prev->stat.switches_out;
+        //still in ready queue - preempted
+        if (prev->ready)
+            ++prev->stat.preempted;
+        else
+            ++prev->stat.voluntary;
+        systime_sub(&prev->run_start, &time, &run);
+        if (systime_compare(&prev->stat.longest_run, &run) > 0)
+            prev->stat.longest_run = run;
+    }
+    if (kprocess != NULL)
+    {
+        ++kprocess->stat.switches_in;
+        kprocess->run_start = time;
+        if (kprocess->woken)
+        {
+            kprocess->woken = false;
+            systime_sub(&kprocess->wakeup_time, &time, &run);
+            ++kprocess->stat.latency[kprocess_stat_bucket(systime_to_us(&run))];
+        }
+    }
+    __KERNEL->stat_process = kprocess;
+#endif //KERNEL_PROCESS_STAT
+}
+
 static inline void switch_to_process(KPROCESS* kprocess)
 {
+    //always switching to ready top, so it's enough to pick it once on unlock
+    if (__KERNEL->schedule_lock)
+    {
+        __KERNEL->schedule_pending = true;
+        return;
+    }
+    KTRACE_INTERNAL(TRACE_SWITCH, kprocess, __KERNEL->active_process);
+    kprocess_stat_switch(kprocess);
+    __KERNEL->scheduled = kprocess;
     __KERNEL->next_process = kprocess;
     pend_switch_context();
 }
 
-void kprocess_add_to_active_list(KPROCESS* kprocess)
+static inline unsigned int kprocess_level(KPROCESS* kprocess)
+{
+    return kprocess->effective_priority < KERNEL_PRIORITY_LEVELS ? kprocess->effective_priority : KERNEL_PRIORITY_LEVELS - 1;
+}
+
+static inline KPROCESS* kprocess_ready_top()
+{
+    unsigned int group;
+    if (__KERNEL->ready.groups == 0)
+        return NULL;
+    group = __builtin_clz(__KERNEL->ready.groups);
+    return __KERNEL->ready.queue[(group << 5) + __builtin_clz(__KERNEL->ready.mask[group])];
+}
+
+static inline void kprocess_ready_add(KPROCESS* kprocess, bool head)
+{
+    unsigned int level = kprocess_level(kprocess);
+    if (__KERNEL->ready.queue[level] == NULL)
+    {
+        __KERNEL->ready.mask[level >> 5] |= 1u << (31 - (level & 31));
+        __KERNEL->ready.groups |= 1u << (31 - (level >> 5));
+    }
+    if (head)
+        dlist_add_head((DLIST**)&__KERNEL->ready.queue[level], (DLIST*)kprocess);
+    else
+        dlist_add_tail((DLIST**)&__KERNEL->ready.queue[level], (DLIST*)kprocess);
+}
+
+static inline void kprocess_ready_remove(KPROCESS* kprocess)
+{
+    unsigned int level = kprocess_level(kprocess);
+    dlist_remove((DLIST**)&__KERNEL->ready.queue[level], (DLIST*)kprocess);
+    if (__KERNEL->ready.queue[level] == NULL)
+    {
+        __KERNEL->ready.mask[level >> 5] &= ~(1u << (31 - (level & 31)));
+        if (__KERNEL->ready.mask[level >> 5] == 0)
+            __KERNEL->ready.groups &= ~(1u << (31 - (level >> 5)));
+    }
+}
+
+static inline void kprocess_stat_start(KPROCESS* kprocess)
 {
-    bool found = false;
-    KPROCESS* kprocess_to_save = kprocess;
-    DLIST_ENUM de;
-    KPROCESS* cur;
 #if (KERNEL_PROCESS_STAT)
     ksystime_get_uptime_internal(&kprocess->uptime_start);
     dlist_remove((DLIST**)&__KERNEL->wait_processes, (DLIST*)kprocess);
+    kprocess->ready = true;
 #endif
+}
+
+static inline void kprocess_stat_stop(KPROCESS* kprocess)
+{
+#if (KERNEL_PROCESS_STAT)
+    dlist_add_tail((DLIST**)&__KERNEL->wait_processes, (DLIST*)kprocess);
+    kprocess->ready = false;
+    SYSTIME time;
+    ksystime_get_uptime_internal(&time);
+    systime_sub(&(kprocess->uptime_start), &time, &time);
+    systime_add(&time, &(kprocess->uptime), &(kprocess->uptime));
+#endif
+}
+
+#if (KERNEL_TIME_SLICE_US)
+static void kprocess_slice_update(bool restart)
+{
+    SYSTIME time;
+    KPROCESS* top = kprocess_ready_top();
+    bool shared = (top != NULL) && (top->list.next != (DLIST*)top);
+    //quantum is armed only while top priority is shared
+    if (restart || !shared)
+        ksystime_timer_stop_internal(&__KERNEL->slice);
+    if (shared && !__KERNEL->slice.active)
+    {
+        us_to_systime(KERNEL_TIME_SLICE_US, &time);
+        ksystime_timer_start_irq_disabled(&__KERNEL->slice, &time);
+    }
+}
+
+void kprocess_slice_timeout(void* param)
+{
+    KPROCESS* top;
+    disable_interrupts();
+    top = kprocess_ready_top();
+    if ((top != NULL) && (top->list.next != (DLIST*)top))
+    {
+        dlist_next((DLIST**)&__KERNEL->ready.queue[kprocess_level(top)]);
+        switch_to_process(kprocess_ready_top());
+    }
+    kprocess_slice_update(false);
+    enable_interrupts();
+}
+#endif //KERNEL_TIME_SLICE_US
+
+void kprocess_add_to_active_list(KPROCESS* kprocess)
+{
+    KPROCESS* top;
+    kprocess_stat_start(kprocess);
+    top = kprocess_ready_top();
     //return from core HALT
-    if (__KERNEL->processes == NULL)
+    if (top == NULL)
     {
-        dlist_add_head((DLIST**)&__KERNEL->processes, (DLIST*)kprocess);
+        kprocess_ready_add(kprocess, false);
         switch_to_process(kprocess);
         return;
     }
-    if (kprocess->base_priority < __KERNEL->processes->base_priority)
+    if (kprocess_level(kprocess) < kprocess_level(top))
     {
-        kprocess_to_save = __KERNEL->processes;
-        dlist_remove_head((DLIST**)&__KERNEL->processes);
-        dlist_add_head((DLIST**)&__KERNEL->processes, (DLIST*)kprocess);
+        //preempted process goes to tail of it's priority queue
+        dlist_next((DLIST**)&__KERNEL->ready.queue[kprocess_level(top)]);
+        kprocess_ready_add(kprocess, false);
         switch_to_process(kprocess);
+#if (KERNEL_TIME_SLICE_US)
+        kprocess_slice_update(true);
+#endif //KERNEL_TIME_SLICE_US
+    }
+    else
+    {
+        kprocess_ready_add(kprocess, false);
+#if (KERNEL_TIME_SLICE_US)
+        kprocess_slice_update(false);
+#endif //KERNEL_TIME_SLICE_US
     }
-
-    //find place for saved kprocess
-    dlist_enum_start((DLIST**)&__KERNEL->processes, &de);
-    while (dlist_enum(&de, (DLIST**)&cur))
-        if (kprocess_to_save->base_priority < cur->base_priority)
-        {
-            dlist_add_before((DLIST**)&__KERNEL->processes, (DLIST*)cur, (DLIST*)kprocess_to_save);
-            found = true;
-            break;
-        }
-    if (!found)
-        dlist_add_tail((DLIST**)&__KERNEL->processes, (DLIST*)kprocess_to_save);
 }
 
 void kprocess_remove_from_active_list(KPROCESS* kprocess)
 {
+    bool active = (kprocess == kprocess_ready_top());
+    kprocess_ready_remove(kprocess);
+    //before switch: not ready anymore, so it's voluntary, and run time is charged till now. Wait list is sharing
+    //list entry with ready queue, so only after remove
+    kprocess_stat_stop(kprocess);
     //freeze active task
-    if (kprocess == __KERNEL->processes)
+    if (active)
     {
-        dlist_remove_head((DLIST**)&__KERNEL->processes);
-        switch_to_process(__KERNEL->processes);
+        switch_to_process(kprocess_ready_top());
+#if (KERNEL_TIME_SLICE_US)
+        kprocess_slice_update(true);
+#endif //KERNEL_TIME_SLICE_US
     }
+#if (KERNEL_TIME_SLICE_US)
     else
-        dlist_remove((DLIST**)&__KERNEL->processes, (DLIST*)kprocess);
-#if (KERNEL_PROCESS_STAT)
-    dlist_add_tail((DLIST**)&__KERNEL->wait_processes, (DLIST*)kprocess);
-    SYSTIME time;
-    ksystime_get_uptime_internal(&time);
-    systime_sub(&(kprocess->uptime_start), &time, &time);
-    systime_add(&time, &(kprocess->uptime), &(kprocess->uptime));
-#endif
+        kprocess_slice_update(false);
+#endif //KERNEL_TIME_SLICE_US
 }
 
-void kprocess_wakeup(HANDLE p)
+//handoff version: process runs right now in rest of current slice, if no better process is ready
+static void kprocess_add_to_active_list_head(KPROCESS* kprocess)
+{
+    KPROCESS* top;
+    kprocess_stat_start(kprocess);
+    top = kprocess_ready_top();
+    if (top == NULL || kprocess_level(kprocess) <= kprocess_level(top))
+    {
+        kprocess_ready_add(kprocess, true);
+        switch_to_process(kprocess);
+    }
+    else
+        kprocess_ready_add(kprocess, false);
+#if (KERNEL_TIME_SLICE_US)
+    kprocess_slice_update(false);
+#endif //KERNEL_TIME_SLICE_US
+}
+
+static void kprocess_update_priority(KPROCESS* kprocess)
+{
+    unsigned int priority;
+    DLIST_ENUM de;
+    KINHERIT* cur;
+    //walk through chain of synchronous calls
+    for (; kprocess != NULL; kprocess = kprocess->server)
+    {
+        priority = kprocess->base_priority;
+        dlist_enum_start((DLIST**)&kprocess->clients, &de);
+        while (dlist_enum(&de, (DLIST**)&cur))
+            if (cur->process->effective_priority < priority)
+                priority = cur->process->effective_priority;
+        if (priority == kprocess->effective_priority)
+            break;
+        if ((kprocess->flags & PROCESS_MODE_MASK) == PROCESS_MODE_ACTIVE)
+        {
+            kprocess_remove_from_active_list(kprocess);
+            kprocess->effective_priority = priority;
+            kprocess_add_to_active_list(kprocess);
+        }
+        else
+            kprocess->effective_priority = priority;
+    }
+}
+
+void kprocess_inherit_priority(HANDLE p, HANDLE caller)
 {
     KPROCESS* process = (KPROCESS*)p;
+    KPROCESS* kcaller = (KPROCESS*)caller;
+    kcaller->server = process;
+    dlist_add_tail((DLIST**)&process->clients, (DLIST*)&kcaller->inherit);
+    kprocess_update_priority(process);
+}
+
+void kprocess_release_priority(HANDLE caller)
+{
+    KPROCESS* kcaller = (KPROCESS*)caller;
+    KPROCESS* server = kcaller->server;
+    if (server == NULL)
+        return;
+    dlist_remove((DLIST**)&server->clients, (DLIST*)&kcaller->inherit);
+    kcaller->server = NULL;
+    kprocess_update_priority(server);
+}
+
+static void kprocess_wakeup_internal(KPROCESS* process, bool handoff)
+{
     if  (process->flags & PROCESS_FLAGS_WAITING)
     {
+        KTRACE_INTERNAL(TRACE_WAKEUP, process, 0);
         //if timer is still active, kill him
         ksystime_timer_stop_internal(&process->timer);
         process->flags &= ~PROCESS_SYNC_MASK;
@@ -105,7 +310,14 @@ void kprocess_wakeup(HANDLE p)
         switch (process->flags & PROCESS_MODE_MASK)
         {
         case PROCESS_MODE_WAITING:
-            kprocess_add_to_active_list(process);
+#if (KERNEL_PROCESS_STAT)
+            ksystime_get_uptime_internal(&process->wakeup_time);
+            process->woken = true;
+#endif //KERNEL_PROCESS_STAT
+            if (handoff)
+                kprocess_add_to_active_list_head(process);
+            else
+                kprocess_add_to_active_list(process);
         case PROCESS_MODE_WAITING_FROZEN:
             process->flags &= ~PROCESS_FLAGS_WAITING;
             break;
@@ -113,6 +325,33 @@ void kprocess_wakeup(HANDLE p)
     }
 }
 
+void kprocess_wakeup(HANDLE p)
+{
+    kprocess_wakeup_internal((KPROCESS*)p, false);
+}
+
+void kprocess_wakeup_handoff(HANDLE p)
+{
+    kprocess_wakeup_internal((KPROCESS*)p, true);
+}
+
+void kprocess_handoff(HANDLE p, HANDLE caller)
+{
+    KPROCESS* process = (KPROCESS*)p;
+    KPROCESS* kcaller = (KPROCESS*)caller;
+    //caller sleeps on IPC without reschedule
+    kprocess_ready_remove(kcaller);
+    kprocess_stat_stop(kcaller);
+    kcaller->flags |= PROCESS_FLAGS_WAITING | PROCESS_SYNC_IPC;
+    kcaller->sync_object = INVALID_HANDLE;
+    //receiver runs in it's place with caller priority
+    kprocess_inherit_priority(p, caller);
+    kprocess_wakeup_internal(process, true);
+    //receiver is frozen, reschedule
+    if ((process->flags & PROCESS_MODE_MASK) != PROCESS_MODE_ACTIVE)
+        switch_to_process(kprocess_ready_top());
+}
+
 void kprocess_timeout(void* param)
 {
     KPROCESS* process = param;
@@ -134,13 +373,14 @@ void kprocess_abnormal_exit()
 
 HANDLE kprocess_create(const REX* rex)
 {
-    unsigned int sys_size;
-    KPROCESS* process = kmalloc(sizeof(KPROCESS));
+    unsigned int sys_size, ipc_size;
+    KPROCESS* process = kslab_alloc(&__KERNEL->slabs[KSLAB_PROCESS]);
     //allocate kprocess object
     if (process != NULL)
     {
         memset(process, 0, sizeof(KPROCESS));
-        sys_size = sizeof(PROCESS) + KERNEL_IPC_COUNT * sizeof(IPC);
+        ipc_size = rex->ipc_size ? rex->ipc_size : KERNEL_IPC_COUNT;
+        sys_size = sizeof(PROCESS) + ipc_size * sizeof(IPC);
         if ((rex->flags & REX_FLAG_PERSISTENT_NAME) == 0)
             sys_size += strlen(rex->name) + 1;
         sys_size = (sys_size + 3) & ~3;
@@ -152,21 +392,28 @@ HANDLE kprocess_create(const REX* rex)
 #endif
             DO_MAGIC(process, MAGIC_PROCESS);
             process->flags = 0;
-            process->base_priority = rex->priority;
+            process->base_priority = process->effective_priority = rex->priority;
+            process->inherit.process = process;
             process->sp = (void*)((unsigned int)process->process + rex->size + sys_size);
             ksystime_timer_init_internal(&process->timer, kprocess_timeout, process);
             process->size = rex->size + sys_size;
-            kipc_init(process);
+            kipc_init(process, ipc_size, (rex->flags & REX_FLAG_IPC_BLOCK) != 0);
+            process->io_chain = (rex->flags & REX_FLAG_IO_CHAIN) != 0;
             process->process->stdout = process->process->stdin = INVALID_HANDLE;
 
             if (rex->flags & REX_FLAG_PERSISTENT_NAME)
                 process->process->name = rex->name;
             else
             {
-                strcpy(((char*)(process->process)) + sizeof(PROCESS) + KERNEL_IPC_COUNT * sizeof(IPC), rex->name);
-                process->process->name = (((const char*)(process->process)) + sizeof(PROCESS)) + KERNEL_IPC_COUNT * sizeof(IPC);
+                strcpy(((char*)(process->process)) + sizeof(PROCESS) + ipc_size * sizeof(IPC), rex->name);
+                process->process->name = (((const char*)(process->process)) + sizeof(PROCESS)) + ipc_size * sizeof(IPC);
             }
-            pool_init(&process->process->pool, (void*)(process->process) + sys_size);
+#if (KERNEL_POOL_TLSF)
+            if (rex->flags & REX_FLAG_POOL_TLSF)
+                pool_init_tlsf(&process->process->pool, (void*)(process->process) + sys_size);
+            else
+#endif //KERNEL_POOL_TLSF
+                pool_init(&process->process->pool, (void*)(process->process) + sys_size);
 
             process_setup_context(process, rex->fn);
 
@@ -182,7 +429,10 @@ HANDLE kprocess_create(const REX* rex)
             }
         }
         else
-            kfree(process);
+        {
+            kslab_free(&__KERNEL->slabs[KSLAB_PROCESS], process);
+            process = NULL;
+        }
     }
     return (HANDLE)process;
 }
@@ -194,6 +444,14 @@ unsigned int kprocess_get_flags(HANDLE p)
     return process->flags;
 }
 
+bool kprocess_io_chain(HANDLE p)
+{
+    //kernel drivers are not chain aware
+    if (p == KERNEL_HANDLE)
+        return false;
+    return ((KPROCESS*)p)->io_chain;
+}
+
 void kprocess_set_flags(HANDLE p, unsigned int flags)
 {
     KPROCESS* process = (KPROCESS*)p;
@@ -232,11 +490,7 @@ void kprocess_set_priority(HANDLE p, unsigned int priority)
     if (process->base_priority != priority)
     {
         process->base_priority = priority;
-        if ((process->flags & PROCESS_MODE_MASK) == PROCESS_MODE_ACTIVE)
-        {
-            kprocess_remove_from_active_list(process);
-            kprocess_add_to_active_list(process);
-        }
+        kprocess_update_priority(process);
     }
     enable_interrupts();
 }
@@ -254,12 +508,52 @@ const char* kprocess_name(HANDLE p)
     return process->process->name;
 }
 
+#if (KERNEL_PROFILING)
+//suggested REX.size: measured peaks with 25% reserve, 16 bytes aligned
+#define PROCESS_SIZE_SUGGEST(used)                              (((used) + (used) / 4 + 15) & ~15)
+
+static void process_watermark(KPROCESS* kprocess, unsigned int* pool, unsigned int* stack, unsigned int* gap)
+{
+    unsigned int cur, start, best_start, best_end, base, top, end;
+    base = (unsigned int)kprocess->process->pool.first_slot & ~3;
+    //allocated, but not written slot is also never touched. Pool peak is at least current pool top
+    top = ((unsigned int)pool_free_ptr(&kprocess->process->pool) + 3) & ~3;
+    end = (unsigned int)kprocess->process + kprocess->size;
+    if (top > end)
+        top = end;
+    best_start = best_end = start = top;
+    //largest never touched region is between pool and stack peaks
+    for (cur = top; cur < end; cur += 4)
+    {
+        if (*((unsigned int*)cur) != MAGIC_UNINITIALIZED)
+            start = cur + 4;
+        else if (cur + 4 - start > best_end - best_start)
+        {
+            best_start = start;
+            best_end = cur + 4;
+        }
+    }
+    *pool = best_start - base;
+    *stack = end - best_end;
+    *gap = best_end - best_start;
+}
+#endif //KERNEL_PROFILING
+
 void kprocess_destroy(HANDLE p)
 {
     KPROCESS* process = (KPROCESS*)p;
+#if (KERNEL_PROFILING) && (KERNEL_DEBUG)
+    unsigned int pool, stack, gap;
+#endif //KERNEL_PROFILING && KERNEL_DEBUG
     if (p == INVALID_HANDLE)
         return;
     CHECK_MAGIC(process, MAGIC_PROCESS);
+#if (KERNEL_PROFILING) && (KERNEL_DEBUG)
+    //last chance to see peak memory usage
+    process_watermark(process, &pool, &stack, &gap);
+    printk("%s exit. stack: %d, pool: %d, gap: %d, suggested size: %d\n", kprocess_name(p), stack, pool, gap,
+           PROCESS_SIZE_SUGGEST(pool + stack));
+#endif //KERNEL_PROFILING && KERNEL_DEBUG
     disable_interrupts();
     CLEAR_MAGIC(process);
     //if kprocess is running, freeze it first
@@ -270,6 +564,15 @@ void kprocess_destroy(HANDLE p)
         if (__KERNEL->active_process == process)
             __KERNEL->active_process = NULL;
     }
+    //stop donating priority and detach our callers
+    kprocess_release_priority(p);
+    while (process->clients)
+    {
+        process->clients->process->server = NULL;
+        dlist_remove_head((DLIST**)&process->clients);
+    }
+    //wakeup senders, blocked on our full queue
+    kipc_destroy(process);
     //if kprocess is owned by any sync object, release them
     if  (process->flags & PROCESS_FLAGS_WAITING)
     {
@@ -290,11 +593,16 @@ void kprocess_destroy(HANDLE p)
     }
 #if (KERNEL_PROCESS_STAT)
     dlist_remove((DLIST**)&__KERNEL->wait_processes, (DLIST*)process);
+    if (__KERNEL->stat_process == process)
+        __KERNEL->stat_process = NULL;
 #endif
+#ifdef POSIX
+    process_destroy_context(process);
+#endif //POSIX
     enable_interrupts();
     //release memory, occupied by kprocess
     kfree(process->process);
-    kfree(process);
+    kslab_free(&__KERNEL->slabs[KSLAB_PROCESS], process);
 }
 
 void kprocess_sleep(HANDLE p, SYSTIME* time, PROCESS_SYNC_TYPE sync_type, HANDLE sync_object)
@@ -312,12 +620,45 @@ void kprocess_sleep(HANDLE p, SYSTIME* time, PROCESS_SYNC_TYPE sync_type, HANDLE
         ksystime_timer_start_internal(&process->timer, time);
 }
 
+#if (KERNEL_PROCESS_STAT)
+void kprocess_get_stat(HANDLE p, PROCESS_STAT* stat)
+{
+    KPROCESS* process = (KPROCESS*)p;
+    CHECK_MAGIC(process, MAGIC_PROCESS);
+    disable_interrupts();
+    memcpy(stat, &process->stat, sizeof(PROCESS_STAT));
+    enable_interrupts();
+}
+#endif //KERNEL_PROCESS_STAT
+
 void kprocess_error(HANDLE p, int error)
 {
     KPROCESS* process = (KPROCESS*)p;
     process->process->error = error;
 }
 
+void kprocess_lock_schedule()
+{
+    disable_interrupts();
+    ++__KERNEL->schedule_lock;
+    enable_interrupts();
+}
+
+void kprocess_unlock_schedule()
+{
+    KPROCESS* top;
+    disable_interrupts();
+    if ((--__KERNEL->schedule_lock == 0) && __KERNEL->schedule_pending)
+    {
+        __KERNEL->schedule_pending = false;
+        top = kprocess_ready_top();
+        //coalesced wakeups can leave running process on top. No switch is required
+        if (top != __KERNEL->scheduled)
+            switch_to_process(top);
+    }
+    enable_interrupts();
+}
+
 HANDLE kprocess_get_current()
 {
     return (__KERNEL->context >= 0) ?  __KERNEL->irqs[__KERNEL->context]->process : (HANDLE)__KERNEL->active_process;
@@ -338,9 +679,14 @@ bool kprocess_check_address(HANDLE p, void* addr, unsigned int size)
 
 void kprocess_init(const REX* rex)
 {
+    kslab_init(&__KERNEL->slabs[KSLAB_PROCESS], sizeof(KPROCESS), KERNEL_SLAB, NULL, KSLAB_MAGIC(KPROCESS, MAGIC_PROCESS));
     __KERNEL->next_process = NULL;
     __KERNEL->active_process = NULL;
-    dlist_clear((DLIST**)&__KERNEL->processes);
+    __KERNEL->scheduled = NULL;
+    memset(&__KERNEL->ready, 0, sizeof(KREADY));
+#if (KERNEL_TIME_SLICE_US)
+    ksystime_timer_init_internal(&__KERNEL->slice, kprocess_slice_timeout, NULL);
+#endif //KERNEL_TIME_SLICE_US
 #if (KERNEL_PROCESS_STAT)
     dlist_clear((DLIST**)&__KERNEL->wait_processes);
 #endif
@@ -355,6 +701,9 @@ void kprocess_switch_test()
     disable_interrupts();
     kprocess_remove_from_active_list(kprocess);
     kprocess_add_to_active_list(kprocess);
+    //called under svc schedule lock. Running process is on top again, force unlock to switch anyway
+    __KERNEL->scheduled = NULL;
+    __KERNEL->schedule_pending = true;
     enable_interrupts();
     //next kprocess is now same as active kprocess, it will simulate context switching
 }
@@ -366,6 +715,15 @@ static unsigned int stack_used(unsigned int top, unsigned int end)
     return end - cur;
 }
 
+static void process_watermark_stat(KPROCESS* kprocess)
+{
+    unsigned int pool, stack, gap, used;
+    process_watermark(kprocess, &pool, &stack, &gap);
+    used = pool + stack;
+    printk("%-20.20s %4b  %4b  %4b  %4b  %9d\n", kprocess_name((HANDLE)kprocess), used + gap, stack, pool, gap,
+           PROCESS_SIZE_SUGGEST(used));
+}
+
 void process_stat(KPROCESS* kprocess)
 {
     void* saved;
@@ -388,6 +746,8 @@ void process_stat(KPROCESS* kprocess)
         printk(" %3b(%02d)   ", stat.used, stat.used_slots);
         printk("%3b/%3b(%02d) ", stat.free, stat.largest_free, stat.free_slots);
     }
+    //IPC queue high-water mark
+    printk("%3d/%-3d ", kprocess->kipc.max, kprocess->process->ipcs.size - 1);
 
 #if (KERNEL_PROCESS_STAT)
     printk("%3d:%02d.%03d", kprocess->uptime.sec / 60, kprocess->uptime.sec % 60, kprocess->uptime.usec / 1000);
@@ -396,6 +756,24 @@ void process_stat(KPROCESS* kprocess)
     __GLOBAL->process = saved;
 }
 
+#if (KERNEL_ALLOC_PROFILING)
+static void process_alloc_stat(KPROCESS* kprocess)
+{
+    kpool_profile(kprocess_name((HANDLE)kprocess), &kprocess->process->pool, kprocess->sp);
+}
+
+static inline void kernel_alloc_stat()
+{
+    int i;
+    KPOOL* kpool;
+    for (i = 0; i < karray_size_internal(__KERNEL->pools); ++i)
+    {
+        kpool = kpool_at(i);
+        kpool_profile(__KERNEL_NAME, &kpool->pool, i == 0 ? get_sp() : (void*)(kpool->base + kpool->size));
+    }
+}
+#endif //KERNEL_ALLOC_PROFILING
+
 static inline void kernel_stat()
 {
     int i;
@@ -427,7 +805,7 @@ static inline void kernel_stat()
         }
         else
         {
-            printk("%3b(%02d)  ", stat.used, stat.used_slots);
+            printk(" %3b(%02d)   ", stat.used, stat.used_slots);
             printk("%3b/%3b(%02d)", stat.free, stat.largest_free, stat.free_slots);
         }
         printk("\n");
@@ -449,9 +827,10 @@ static inline void kernel_stat()
         printk(DAMAGED);
     else
     {
-        printk("%3b(%02d)  ", total.used, total.used_slots);
+        printk(" %3b(%02d)   ", total.used, total.used_slots);
         printk("%3b/%3b(%02d)", total.free, total.largest_free, total.free_slots);
     }
+    printk("         ");
 
 #if (KERNEL_PROCESS_STAT)
     ksystime_get_uptime_internal(&uptime);
@@ -461,31 +840,49 @@ static inline void kernel_stat()
     __GLOBAL->process = saved;
 }
 
-void kprocess_info()
+static int kprocess_enum(void (*fn)(KPROCESS*))
 {
     int cnt = 0;
+    unsigned int group, mask, level;
     DLIST_ENUM de;
     KPROCESS* cur;
-#if (KERNEL_PROCESS_STAT)
-    printk("\n    name           priority  stack  size   used       free        uptime\n");
-#else
-    printk("\n    name           priority  stack  size   used       free\n");
-#endif
-    printk(STAT_LINE);
-    disable_interrupts();
-    dlist_enum_start((DLIST**)&__KERNEL->processes, &de);
-    while (dlist_enum(&de, (DLIST**)&cur))
+    //non-empty levels only
+    for (group = 0; group < KERNEL_PRIORITY_GROUPS; ++group)
     {
-        process_stat(cur);
-        ++cnt;
+        for (mask = __KERNEL->ready.mask[group]; mask; mask &= ~(1u << (31 - __builtin_clz(mask))))
+        {
+            level = (group << 5) + __builtin_clz(mask);
+            dlist_enum_start((DLIST**)&__KERNEL->ready.queue[level], &de);
+            while (dlist_enum(&de, (DLIST**)&cur))
+            {
+                fn(cur);
+                ++cnt;
+            }
+        }
     }
 #if (KERNEL_PROCESS_STAT)
     dlist_enum_start((DLIST**)&__KERNEL->wait_processes, &de);
     while (dlist_enum(&de, (DLIST**)&cur))
     {
-        process_stat(cur);
+        fn(cur);
         ++cnt;
     }
+#endif
+    return cnt;
+}
+
+void kprocess_info()
+{
+    int cnt;
+#if (KERNEL_PROCESS_STAT)
+    printk("\n    name           priority  stack  size   used       free        ipc    uptime\n");
+#else
+    printk("\n    name           priority  stack  size   used       free        ipc\n");
+#endif
+    printk(STAT_LINE);
+    disable_interrupts();
+    cnt = kprocess_enum(process_stat);
+#if (KERNEL_PROCESS_STAT)
     printk("total %d processess\n", cnt);
 #else
     printk("total %d active processess\n", cnt);
@@ -494,6 +891,22 @@ void kprocess_info()
 
     kernel_stat();
     printk(STAT_LINE);
+    kslab_stat();
+    printk(STAT_LINE);
+#if (KERNEL_ALLOC_PROFILING)
+    //live and peak bytes by allocation site
+    printk("\n    site    live  peak  count\n");
+    printk(STAT_LINE);
+    kprocess_enum(process_alloc_stat);
+    kernel_alloc_stat();
+    printk(STAT_LINE);
+#endif //KERNEL_ALLOC_PROFILING
+
+    //peak memory usage, based on untouched magic
+    printk("\n    name             size stack  pool   gap  suggested\n");
+    printk(STAT_LINE);
+    kprocess_enum(process_watermark_stat);
+    printk(STAT_LINE);
     enable_interrupts();
 }
 #endif //KERNEL_PROFILING
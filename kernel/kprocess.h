@@ -19,6 +19,7 @@ void kprocess_set_priority(HANDLE p, unsigned int priority);
 void kprocess_destroy(HANDLE p);
 unsigned int kprocess_get_flags(HANDLE p);
 unsigned int kprocess_get_priority(HANDLE p);
+bool kprocess_io_chain(HANDLE p);
 void kprocess_sleep(HANDLE p, SYSTIME* time, PROCESS_SYNC_TYPE sync_type, HANDLE sync_object);
 bool kprocess_check_address(HANDLE p, void* addr, unsigned int size);
 void kprocess_error(HANDLE p, int error);
@@ -27,10 +28,24 @@ const char* kprocess_name(HANDLE p);
 
 //called while IRQ disabled
 void kprocess_wakeup(HANDLE p);
+void kprocess_inherit_priority(HANDLE p, HANDLE caller);
+void kprocess_release_priority(HANDLE caller);
+//wakeup and run right now in rest of current slice, if priority allows
+void kprocess_wakeup_handoff(HANDLE p);
+//current process caller sleeps on IPC, p is waked up and runs in it's place
+void kprocess_handoff(HANDLE p, HANDLE caller);
+
+//delay reschedule until unlocked. Nested calls are allowed
+void kprocess_lock_schedule();
+void kprocess_unlock_schedule();
 
 //called from startup
 void kprocess_init(const REX *rex);
 
+#if (KERNEL_PROCESS_STAT)
+void kprocess_get_stat(HANDLE p, PROCESS_STAT* stat);
+#endif //KERNEL_PROCESS_STAT
+
 #if (KERNEL_PROFILING)
 //called from svc, IRQ disabled
 void kprocess_switch_test();
@@ -5,6 +5,7 @@
 #include "../userspace/systime.h"
 #include "../userspace/types.h"
 #include "../userspace/irq.h"
+#include "../userspace/process.h"
 #include "kernel_config.h"
 #include "dbg.h"
 
@@ -18,18 +19,66 @@ typedef struct {
 #endif
 }KIRQ;
 
+//timing wheel. Current second is in usec buckets, indexed by bitmap. Next seconds are hashed by sec
+#define KTIMER_USEC_BUCKETS                     32
+#define KTIMER_USEC_BUCKET_SIZE                 (1000000 / KTIMER_USEC_BUCKETS)
+#define KTIMER_SEC_BUCKETS                      16
+
 typedef struct _KTIMER {
     DLIST list;
     SYSTIME time;
     void (*callback)(void*);
     void* param;
     bool active;
+    //wheel bucket, timer is linked in
+    struct _KTIMER** head;
 } KTIMER;
 
+typedef struct {
+    DLIST list;
+    struct _KPROCESS* process;
+}KINHERIT;
+
+typedef enum {
+    KSLAB_PROCESS = 0,
+    KSLAB_STREAM,
+    KSLAB_STREAM_HANDLE,
+    KSLAB_SOFT_TIMER,
+    KSLAB_MAX
+} KSLAB_TYPE;
+
+typedef struct {
+    //released objects, ready for reuse
+    DLIST* free;
+    unsigned int size;
+    //max objects in free list
+    unsigned int limit;
+    //called once, on allocation from pool
+    void (*ctor)(void*);
+#if (KERNEL_MARKS)
+    unsigned int magic;
+    unsigned int magic_offset;
+#endif //KERNEL_MARKS
+    unsigned int free_count, used;
+    unsigned int hits, misses;
+}KSLAB;
+
+#define KIO_CACHE_CLASSES                   4
+//max receivers of one shared IO at once
+#define KIO_SHARED_HOLDERS                  8
+
 typedef struct {
     //process, we are waiting for. Can be INVALID_HANDLE, then waiting from any process
     HANDLE wait_process;
     unsigned int cmd, param1;
+    //block senders on full queue
+    bool block;
+    //queue high-water mark
+    unsigned int max;
+    //item of receiver blocked senders list
+    KINHERIT blocked;
+    //senders, waiting for free space in our queue
+    KINHERIT* senders;
 }KIPC;
 
 typedef struct _KPROCESS {
@@ -40,13 +89,44 @@ typedef struct _KPROCESS {
     unsigned int size;
     unsigned long flags;
     unsigned base_priority;                                            //base priority
+    unsigned effective_priority;                                       //base priority, raised by pending IPC callers
+    struct _KPROCESS* server;                                          //process, inheriting our priority while we are calling it
+    KINHERIT inherit;                                                  //item of server clients list
+    KINHERIT* clients;                                                 //callers, donating their priority to us
     KTIMER timer;                                                      //timer for process sleep and sync objects timeouts
     HANDLE sync_object;                                                //sync object we are waiting for
+    bool io_chain;                                                     //IO chain fragments are supported
 #if (KERNEL_PROCESS_STAT)
     SYSTIME uptime;
     SYSTIME uptime_start;
+    PROCESS_STAT stat;
+    SYSTIME run_start;
+    SYSTIME wakeup_time;
+    bool ready;                                                        //in ready queue
+    bool woken;                                                        //waked up, not running yet
 #endif //KERNEL_PROCESS_STAT
     KIPC kipc;
 }KPROCESS;
 
+//must be above highest distinct priority. Drivers and services in tree are using 91..161
+#ifndef KERNEL_PRIORITY_LEVELS
+#define KERNEL_PRIORITY_LEVELS                                         192
+#endif
+
+#define KERNEL_PRIORITY_GROUPS                                         ((KERNEL_PRIORITY_LEVELS + 31) / 32)
+
+//groups bitmap is single 32 bit word
+#if (KERNEL_PRIORITY_GROUPS > 32)
+#error KERNEL_PRIORITY_LEVELS is too high. Maximum is 1024
+#endif
+
+typedef struct {
+    //bit per non-empty group of 32 levels. MSB - highest priority group
+    unsigned int groups;
+    //bit per non-empty level inside group. MSB - highest priority level
+    unsigned int mask[KERNEL_PRIORITY_GROUPS];
+    //FIFO of active processes per priority level
+    KPROCESS* queue[KERNEL_PRIORITY_LEVELS];
+}KREADY;
+
 #endif // KPROCESS_PRIVATE_H
@@ -0,0 +1,95 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "kslab.h"
+#include "kstdlib.h"
+#include "dbg.h"
+
+#if (KERNEL_PROFILING)
+static const char* const __KSLAB_NAMES[KSLAB_MAX] =                 {"process", "stream", "stream handle", "soft timer"};
+#endif //KERNEL_PROFILING
+
+void kslab_init(KSLAB* slab, unsigned int size, unsigned int limit, void (*ctor)(void*), unsigned int magic, unsigned int magic_offset)
+{
+    slab->free = NULL;
+    slab->size = size;
+    slab->limit = limit;
+    slab->ctor = ctor;
+#if (KERNEL_MARKS)
+    slab->magic = magic;
+    slab->magic_offset = magic_offset;
+#endif //KERNEL_MARKS
+    slab->free_count = slab->used = slab->hits = slab->misses = 0;
+}
+
+void* kslab_alloc(KSLAB* slab)
+{
+    void* obj = NULL;
+    disable_interrupts();
+    if (slab->free != NULL)
+    {
+        obj = slab->free;
+        dlist_remove_head(&slab->free);
+        --slab->free_count;
+        ++slab->hits;
+        ++slab->used;
+    }
+    enable_interrupts();
+    if (obj == NULL)
+    {
+        obj = kmalloc(slab->size);
+        if (obj == NULL)
+            return NULL;
+        if (slab->ctor != NULL)
+            slab->ctor(obj);
+        disable_interrupts();
+        ++slab->misses;
+        ++slab->used;
+        enable_interrupts();
+    }
+#if (KERNEL_MARKS)
+    *(unsigned int*)((unsigned int)obj + slab->magic_offset) = slab->magic;
+#endif //KERNEL_MARKS
+    return obj;
+}
+
+void kslab_free(KSLAB* slab, void* obj)
+{
+    bool cached = false;
+#if (KERNEL_MARKS)
+    *(unsigned int*)((unsigned int)obj + slab->magic_offset) = 0;
+#endif //KERNEL_MARKS
+    disable_interrupts();
+    --slab->used;
+    if (slab->free_count < slab->limit)
+    {
+        dlist_add_head(&slab->free, (DLIST*)obj);
+        ++slab->free_count;
+        cached = true;
+    }
+    enable_interrupts();
+    if (!cached)
+        kfree(obj);
+}
+
+#if (KERNEL_PROFILING)
+static void kslab_stat_line(const char* name, KSLAB* slab)
+{
+    printk("    %-14s %4b  %-6d  %-6d  %-9d  %-9d\n", name, slab->size, slab->used, slab->free_count, slab->hits, slab->misses);
+}
+
+void kslab_stat()
+{
+    int i;
+    printk("\n    slab           size  used    cached  hits       misses\n");
+    for (i = 0; i < KSLAB_MAX; ++i)
+        kslab_stat_line(__KSLAB_NAMES[i], &__KERNEL->slabs[i]);
+#if (KERNEL_IO_CACHE)
+    for (i = 0; i < KIO_CACHE_CLASSES; ++i)
+        kslab_stat_line("io", &__KERNEL->io_cache[i]);
+#endif //KERNEL_IO_CACHE
+}
+#endif //KERNEL_PROFILING
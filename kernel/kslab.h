@@ -0,0 +1,38 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef KSLAB_H
+#define KSLAB_H
+
+/*
+    kslab.h - caches of fixed size kernel objects. Released object is kept in cache free list and reused
+    without pool search. Constructor is called only on allocation from pool, so reused object keeps constructed state
+*/
+
+#include "kernel.h"
+#include <stddef.h>
+
+//not defined in old projects config. Caching is disabled
+#ifndef KERNEL_SLAB
+#define KERNEL_SLAB                                         0
+#endif
+
+#if (KERNEL_MARKS)
+#define KSLAB_MAGIC(type, magic_value)                      (magic_value), offsetof(type, magic)
+#else
+#define KSLAB_MAGIC(type, magic_value)                      0, 0
+#endif //KERNEL_MARKS
+
+void kslab_init(KSLAB* slab, unsigned int size, unsigned int limit, void (*ctor)(void*), unsigned int magic, unsigned int magic_offset);
+void* kslab_alloc(KSLAB* slab);
+void kslab_free(KSLAB* slab, void* obj);
+
+#if (KERNEL_PROFILING)
+//called from kprocess_info
+void kslab_stat();
+#endif //KERNEL_PROFILING
+
+#endif // KSLAB_H
@@ -38,14 +38,59 @@ static int kpool_idx(void* ptr)
     return -1;
 }
 
+#if (KERNEL_ALLOC_PROFILING)
+static void* kstdlib_caller(void* ret)
+{
+    void* caller = __KERNEL->alloc_caller != NULL ? __KERNEL->alloc_caller : ret;
+    __KERNEL->alloc_caller = NULL;
+    return caller;
+}
+
+#if (KERNEL_PROFILING)
+static void kpool_profile_site(POOL_SITE* site)
+{
+    if (site->caller != NULL)
+        printk("%#08X  ", (unsigned int)site->caller);
+    else
+        printk("other       ");
+    printk("%4b  %4b  %5d\n", site->live, site->peak, site->count);
+}
+
+void kpool_profile(const char* name, POOL* pool, void* sp)
+{
+    int i;
+    POOL_STAT stat;
+    POOL_PROFILE* profile = (POOL_PROFILE*)pool->profile;
+    //free slots only. Space between last slot and sp is not fragmentation, it's reported separately
+    ((const LIB_STD*)__GLOBAL->lib[LIB_ID_STD])->pool_stat(pool, &stat, pool->last_slot);
+    //0% - all free slots space is in single block
+    printk("%-20.20s free: %b, largest: %b, fragmentation: %d%%, headroom: %b\n", name, stat.free, stat.largest_free,
+           stat.free ? 100 - stat.largest_free * 100 / stat.free : 0, (unsigned int)sp - (unsigned int)pool->last_slot);
+    printk("sizes:");
+    for (i = 0; i < POOL_PROFILE_BUCKETS; ++i)
+        printk(" %d:%d", POOL_PROFILE_MIN_SIZE << i, profile->sizes[i]);
+    printk("+\n");
+    for (i = 0; i < KERNEL_ALLOC_PROFILING; ++i)
+        if (profile->sites[i].peak)
+            kpool_profile_site(&profile->sites[i]);
+}
+#endif //KERNEL_PROFILING
+#endif //KERNEL_ALLOC_PROFILING
+
 void* kmalloc_internal(size_t size)
 {
     int idx;
     void* res;
     KPOOL* kpool;
+#if (KERNEL_ALLOC_PROFILING)
+    void* caller = kstdlib_caller(__builtin_return_address(0));
+#endif //KERNEL_ALLOC_PROFILING
     for (idx = karray_size_internal(__KERNEL->pools) - 1; idx >= 0; --idx)
     {
         kpool = kpool_at(idx);
+#if (KERNEL_ALLOC_PROFILING)
+        kpool->pool.caller = caller;
+#endif //KERNEL_ALLOC_PROFILING
         res = ((const LIB_STD*)__GLOBAL->lib[LIB_ID_STD])->pool_malloc(&kpool_at(idx)->pool, size, idx == 0 ? get_sp() : (void*)(kpool->base + kpool->size));
         if (res)
             return res;
@@ -57,6 +102,9 @@ void* kmalloc(size_t size)
 {
     void* res;
     disable_interrupts();
+#if (KERNEL_ALLOC_PROFILING)
+    __KERNEL->alloc_caller = __builtin_return_address(0);
+#endif //KERNEL_ALLOC_PROFILING
     res = kmalloc_internal(size);
     enable_interrupts();
     return res;
@@ -67,13 +115,22 @@ void* krealloc_internal(void* ptr, size_t size)
     void* res;
     KPOOL* kpool;
     int idx, idx_cur;
+#if (KERNEL_ALLOC_PROFILING)
+    void* caller;
+#endif //KERNEL_ALLOC_PROFILING
     if (ptr == NULL)
         return kmalloc_internal(size);
+#if (KERNEL_ALLOC_PROFILING)
+    caller = kstdlib_caller(__builtin_return_address(0));
+#endif //KERNEL_ALLOC_PROFILING
     idx_cur = kpool_idx(ptr);
 
     if (idx_cur < 0)
         return NULL;
     kpool = kpool_at(idx_cur);
+#if (KERNEL_ALLOC_PROFILING)
+    kpool->pool.caller = caller;
+#endif //KERNEL_ALLOC_PROFILING
     res = ((const LIB_STD*)__GLOBAL->lib[LIB_ID_STD])->pool_realloc(&kpool->pool, ptr, size, idx_cur == 0 ? get_sp() : (void*)(kpool->base + kpool->size));
     if (res != NULL)
         return res;
@@ -83,6 +140,9 @@ void* krealloc_internal(void* ptr, size_t size)
         if (idx == idx_cur)
             continue;
         kpool = kpool_at(idx);
+#if (KERNEL_ALLOC_PROFILING)
+        kpool->pool.caller = caller;
+#endif //KERNEL_ALLOC_PROFILING
         res = ((const LIB_STD*)__GLOBAL->lib[LIB_ID_STD])->pool_malloc(&kpool_at(idx)->pool, size, idx == 0 ? get_sp() : (void*)(kpool->base + kpool->size));
         if (res != NULL)
         {
@@ -98,6 +158,9 @@ void* krealloc(void* ptr, size_t size)
 {
     void* res;
     disable_interrupts();
+#if (KERNEL_ALLOC_PROFILING)
+    __KERNEL->alloc_caller = __builtin_return_address(0);
+#endif //KERNEL_ALLOC_PROFILING
     res = krealloc_internal(ptr, size);
     enable_interrupts();
     return res;
@@ -146,7 +209,11 @@ void kstdlib_init()
     POOL pool;
     KPOOL* kpool0;
 
+#if (KERNEL_POOL_TLSF)
+    pool_init_tlsf(&pool, (void*)(SRAM_BASE + KERNEL_GLOBAL_SIZE + sizeof(KERNEL)));
+#else
     pool_init(&pool, (void*)(SRAM_BASE + KERNEL_GLOBAL_SIZE + sizeof(KERNEL)));
+#endif //KERNEL_POOL_TLSF
     //Not array at this point, just single pool - we need something global
     __KERNEL->pools = (ARRAY*)&pool;
     //make sure error processing will be passed to valid pointer
@@ -178,6 +245,10 @@ void kstdlib_add_pool(unsigned int base, unsigned int size)
     kpool = karray_append(&__KERNEL->pools);
     kpool->base = base;
     kpool->size = size;
+#if (KERNEL_POOL_TLSF)
+    pool_init_tlsf(&kpool->pool, (void*)base);
+#else
     pool_init(&kpool->pool, (void*)base);
+#endif //KERNEL_POOL_TLSF
     enable_interrupts();
 }
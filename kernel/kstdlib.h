@@ -72,6 +72,9 @@ extern const STD_MEM __KSTD_MEM;
 void kstdlib_init();
 KPOOL* kpool_at(unsigned int idx);
 void kpool_stat(unsigned int idx, POOL_STAT* stat);
+#if (KERNEL_PROFILING) && (KERNEL_ALLOC_PROFILING)
+void kpool_profile(const char* name, POOL* pool, void* sp);
+#endif //(KERNEL_PROFILING) && (KERNEL_ALLOC_PROFILING)
 
 //called from svc
 void kstdlib_add_pool(unsigned int base, unsigned int size);
@@ -14,6 +14,9 @@
 #include "../userspace/rb.h"
 #include "../userspace/dlist.h"
 #include "dbg.h"
+#include "ktrace.h"
+#include "ksystime.h"
+#include "kslab.h"
 
 typedef enum {
     STREAM_MODE_IDLE,
@@ -32,6 +35,18 @@ typedef struct {
     HANDLE listener;
     unsigned int listener_param;
     HAL listener_hal;
+    //inform listener only when size reached, or data is waiting for timeout
+    unsigned int listener_size;
+    unsigned int listener_timeout_us;
+    //watermark is kept only for process, which set it
+    HANDLE watermark_process;
+    KTIMER listener_timer;
+    //handles, owning acquired regions of ring. Released size is clamped to acquired span
+    struct _STREAM_HANDLE* read_owner;
+    struct _STREAM_HANDLE* write_owner;
+    char* read_ptr;
+    char* write_ptr;
+    unsigned int read_len, write_len;
 }STREAM;
 
 typedef struct _STREAM_HANDLE{
@@ -44,6 +59,103 @@ typedef struct _STREAM_HANDLE{
     unsigned int size;
 }STREAM_HANDLE;
 
+//ring can wrap only once, so at most two memcpy. Called while IRQ disabled
+static unsigned int kstream_rb_put(STREAM* stream, const char* buf, unsigned int size)
+{
+    unsigned int offset, chunk;
+    unsigned int res = 0;
+    while (res < size)
+    {
+        chunk = size - res;
+        offset = rb_put_span(&stream->rb, &chunk);
+        if (chunk == 0)
+            break;
+        memcpy(stream->data + offset, buf + res, chunk);
+        res += chunk;
+    }
+    return res;
+}
+
+//called while IRQ disabled
+static unsigned int kstream_rb_get(STREAM* stream, char* buf, unsigned int size)
+{
+    unsigned int offset, chunk;
+    unsigned int res = 0;
+    while (res < size)
+    {
+        chunk = size - res;
+        offset = rb_get_span(&stream->rb, &chunk);
+        if (chunk == 0)
+            break;
+        memcpy(buf + res, stream->data + offset, chunk);
+        res += chunk;
+    }
+    return res;
+}
+
+//feed blocked readers from ring. Called while IRQ disabled
+static unsigned int kstream_pull_readers(STREAM* stream)
+{
+    STREAM_HANDLE* reader;
+    unsigned int pulled;
+    unsigned int res = 0;
+    //acquired region can't be consumed
+    if (stream->read_owner != NULL)
+        return 0;
+    while ((reader = stream->read_waiters) != NULL)
+    {
+        pulled = kstream_rb_get(stream, reader->buf, reader->size);
+        reader->buf += pulled;
+        reader->size -= pulled;
+        res += pulled;
+        //stream is empty
+        if (reader->size)
+            break;
+        dlist_remove_head((DLIST**)&stream->read_waiters);
+        KTRACE_INTERNAL(TRACE_STREAM_UNBLOCK, reader->process, reader);
+        kprocess_wakeup(reader->process);
+        reader->mode = STREAM_MODE_IDLE;
+    }
+    return res;
+}
+
+//push blocked writers to ring. Called while IRQ disabled
+static unsigned int kstream_push_writers(STREAM* stream)
+{
+    STREAM_HANDLE* writer;
+    unsigned int pushed;
+    unsigned int res = 0;
+    //acquired region can't be overwritten
+    if (stream->write_owner != NULL)
+        return 0;
+    while ((writer = stream->write_waiters) != NULL)
+    {
+        pushed = kstream_rb_put(stream, writer->buf, writer->size);
+        writer->buf += pushed;
+        writer->size -= pushed;
+        res += pushed;
+        //stream is full
+        if (writer->size)
+            break;
+        //writed all from waiter? Wake him up.
+        dlist_remove_head((DLIST**)&stream->write_waiters);
+        KTRACE_INTERNAL(TRACE_STREAM_UNBLOCK, writer->process, writer);
+        kprocess_wakeup(writer->process);
+        writer->mode = STREAM_MODE_IDLE;
+    }
+    return res;
+}
+
+//waiters can be deferred while region acquired. Called while IRQ disabled
+static void kstream_sync(STREAM* stream)
+{
+    unsigned int moved;
+    do {
+        moved = kstream_pull_readers(stream);
+        moved += kstream_push_writers(stream);
+    } while (moved);
+}
+
 unsigned int kstream_get_size_internal(STREAM* stream)
 {
     unsigned int size;
@@ -53,6 +165,62 @@ unsigned int kstream_get_size_internal(STREAM* stream)
     return size;
 }
 
+static void kstream_inform(STREAM* stream, unsigned int size)
+{
+    IPC ipc;
+    disable_interrupts();
+    ksystime_timer_stop_internal(&stream->listener_timer);
+    enable_interrupts();
+    ipc.process = stream->listener;
+    ipc.cmd = HAL_CMD(stream->listener_hal, IPC_STREAM_WRITE);
+    ipc.param1 = (unsigned int)stream->listener_param;
+    ipc.param2 = (HANDLE)stream;
+    ipc.param3 = size;
+    stream->listener = INVALID_HANDLE;
+    kipc_post(KERNEL_HANDLE, &ipc);
+}
+
+static void kstream_check_inform(STREAM* stream)
+{
+    unsigned int size;
+    SYSTIME time;
+    size = kstream_get_size_internal(stream);
+    if (!size || (stream->listener == INVALID_HANDLE))
+        return;
+    //inform listener
+    if (size >= stream->listener_size)
+        kstream_inform(stream, size);
+    //don't hold data too long. Called from IRQ too: check and start must be atomic, or timer is inserted twice
+    else if (stream->listener_timeout_us)
+    {
+        us_to_systime(stream->listener_timeout_us, &time);
+        disable_interrupts();
+        if (!stream->listener_timer.active)
+            ksystime_timer_start_irq_disabled(&stream->listener_timer, &time);
+        enable_interrupts();
+    }
+}
+
+//back to inform on any byte
+static void kstream_watermark_reset(STREAM* stream)
+{
+    stream->listener_size = 1;
+    stream->listener_timeout_us = 0;
+    stream->watermark_process = INVALID_HANDLE;
+    disable_interrupts();
+    ksystime_timer_stop_internal(&stream->listener_timer);
+    enable_interrupts();
+}
+
+static void kstream_listener_timeout(void* param)
+{
+    unsigned int size;
+    STREAM* stream = (STREAM*)param;
+    size = kstream_get_size_internal(stream);
+    if (size && (stream->listener != INVALID_HANDLE))
+        kstream_inform(stream, size);
+}
+
 unsigned int kstream_get_size(HANDLE s)
 {
     STREAM* stream = (STREAM*)s;
@@ -88,22 +256,37 @@ void kstream_lock_release(HANDLE h, HANDLE process)
     handle->mode = STREAM_MODE_IDLE;
 }
 
+static void kstream_ctor(void* obj)
+{
+    STREAM* stream = (STREAM*)obj;
+    ksystime_timer_init_internal(&stream->listener_timer, kstream_listener_timeout, stream);
+}
+
+void kstream_init()
+{
+    kslab_init(&__KERNEL->slabs[KSLAB_STREAM], sizeof(STREAM), KERNEL_SLAB, kstream_ctor, KSLAB_MAGIC(STREAM, MAGIC_STREAM));
+    kslab_init(&__KERNEL->slabs[KSLAB_STREAM_HANDLE], sizeof(STREAM_HANDLE), KERNEL_SLAB, NULL, KSLAB_MAGIC(STREAM_HANDLE, MAGIC_STREAM_HANDLE));
+}
+
 HANDLE kstream_create(unsigned int size)
 {
-    STREAM* stream = kmalloc(sizeof(STREAM));
+    STREAM* stream = kslab_alloc(&__KERNEL->slabs[KSLAB_STREAM]);
     if (stream == NULL)
         return INVALID_HANDLE;
     //allocate stream data
     stream->data = kmalloc(size);
     if (stream->data == NULL)
     {
-        kfree(stream);
+        kslab_free(&__KERNEL->slabs[KSLAB_STREAM], stream);
         return INVALID_HANDLE;
     }
-    DO_MAGIC(stream, MAGIC_STREAM);
     rb_init(&stream->rb, size);
     stream->listener = INVALID_HANDLE;
     stream->write_waiters = stream->read_waiters = NULL;
+    stream->read_owner = stream->write_owner = NULL;
+    stream->listener_size = 1;
+    stream->listener_timeout_us = 0;
+    stream->watermark_process = INVALID_HANDLE;
     return (HANDLE)stream;
 }
 
@@ -114,11 +297,10 @@ HANDLE kstream_open(HANDLE process, HANDLE s)
     if (s == INVALID_HANDLE)
         return INVALID_HANDLE;
     CHECK_MAGIC(stream, MAGIC_STREAM);
-    handle = kmalloc(sizeof(STREAM_HANDLE));
+    handle = kslab_alloc(&__KERNEL->slabs[KSLAB_STREAM_HANDLE]);
     if (handle == NULL)
         return INVALID_HANDLE;
 
-    DO_MAGIC(handle, MAGIC_STREAM_HANDLE);
     handle->process = process;
     handle->stream = stream;
     handle->mode = STREAM_MODE_IDLE;
@@ -141,25 +323,18 @@ void kstream_close(HANDLE process, HANDLE h)
         error(ERROR_ACCESS_DENIED);
         return;
     }
-    kfree(handle);
-}
-
-static void kstream_check_inform(STREAM* stream)
-{
-    unsigned int size;
-    IPC ipc;
-    size = kstream_get_size_internal(stream);
-    //inform listener
-    if (size && (stream->listener != INVALID_HANDLE))
+    //drop acquired regions without commit
+    if (handle->stream->read_owner == handle || handle->stream->write_owner == handle)
     {
-        ipc.process = stream->listener;
-        ipc.cmd = HAL_CMD(stream->listener_hal, IPC_STREAM_WRITE);
-        ipc.param1 = (unsigned int)stream->listener_param;
-        ipc.param2 = (HANDLE)stream;
-        ipc.param3 = size;
-        stream->listener = INVALID_HANDLE;
-        kipc_post(KERNEL_HANDLE, &ipc);
+        disable_interrupts();
+        if (handle->stream->read_owner == handle)
+            handle->stream->read_owner = NULL;
+        if (handle->stream->write_owner == handle)
+            handle->stream->write_owner = NULL;
+        kstream_sync(handle->stream);
+        enable_interrupts();
     }
+    kslab_free(&__KERNEL->slabs[KSLAB_STREAM_HANDLE], handle);
 }
 
 void kstream_listen(HANDLE process, HANDLE s, unsigned int param, HAL hal)
@@ -172,6 +347,9 @@ void kstream_listen(HANDLE process, HANDLE s, unsigned int param, HAL hal)
         return;
     }
 
+    //listener is informed once, same process is listening again with own watermark
+    if (stream->watermark_process != process)
+        kstream_watermark_reset(stream);
     stream->listener = process;
     stream->listener_param = param;
     stream->listener_hal = hal;
@@ -187,16 +365,44 @@ void kstream_stop_listen(HANDLE process, HANDLE s)
         error(ERROR_ACCESS_DENIED);
         return;
     }
+    kstream_watermark_reset(stream);
     stream->listener = INVALID_HANDLE;
 }
 
+void kstream_listen_watermark(HANDLE process, HANDLE s, unsigned int size, unsigned int timeout_us)
+{
+    STREAM* stream = (STREAM*)s;
+    CHECK_MAGIC(stream, MAGIC_STREAM);
+    if (stream->listener != process)
+    {
+        error(ERROR_ACCESS_DENIED);
+        return;
+    }
+    //stream can't hold more
+    if (size >= stream->rb.size)
+        size = stream->rb.size - 1;
+    stream->listener_size = size ? size : 1;
+    stream->listener_timeout_us = timeout_us;
+    stream->watermark_process = process;
+    disable_interrupts();
+    ksystime_timer_stop_internal(&stream->listener_timer);
+    enable_interrupts();
+    kstream_check_inform(stream);
+}
+
 unsigned int kstream_write_no_block_internal(STREAM_HANDLE *handle, char* buf, unsigned int size_max)
 {
     register STREAM_HANDLE* reader;
     unsigned int to_write = size_max;
     disable_interrupts();
-    //write directly to output
-    while (to_write && (reader = handle->stream->read_waiters) != NULL)
+    //ring is owned by acquired region
+    if (handle->stream->write_owner != NULL)
+    {
+        enable_interrupts();
+        return 0;
+    }
+    //write directly to output. Not while acquired data is waiting in ring
+    while (to_write && handle->stream->read_owner == NULL && (reader = handle->stream->read_waiters) != NULL)
     {
         //all can go directly
         if (reader->size <= to_write)
@@ -205,6 +411,7 @@ unsigned int kstream_write_no_block_internal(STREAM_HANDLE *handle, char* buf, u
             to_write -= reader->size;
             buf += reader->size;
             dlist_remove_head((DLIST**)&handle->stream->read_waiters);
+            KTRACE_INTERNAL(TRACE_STREAM_UNBLOCK, reader->process, reader);
             kprocess_wakeup(reader->process);
             reader->mode = STREAM_MODE_IDLE;
         }
@@ -219,8 +426,7 @@ unsigned int kstream_write_no_block_internal(STREAM_HANDLE *handle, char* buf, u
         }
     }
     //write rest to stream
-    for(; to_write && !rb_is_full(&handle->stream->rb); --to_write)
-        handle->stream->data[rb_put(&handle->stream->rb)] = *buf++;
+    to_write -= kstream_rb_put(handle->stream, buf, to_write);
     enable_interrupts();
     return size_max - to_write;
 }
@@ -246,6 +452,7 @@ void kstream_write(HANDLE process, HANDLE h, char* buf, unsigned int size)
         handle->mode = STREAM_MODE_WRITE;
         kprocess_sleep(process, NULL, PROCESS_SYNC_STREAM, h);
         disable_interrupts();
+        KTRACE_INTERNAL(TRACE_STREAM_BLOCK, process, h);
         dlist_add_tail((DLIST**)&handle->stream->write_waiters, (DLIST*)handle);
         enable_interrupts();
     }
@@ -255,13 +462,19 @@ void kstream_write(HANDLE process, HANDLE h, char* buf, unsigned int size)
 unsigned int kstream_read_no_block(HANDLE h, char* buf, unsigned int size_max)
 {
     register STREAM_HANDLE* writer;
-    register unsigned int to_read, to_push;
+    register unsigned int to_read;
     STREAM_HANDLE* handle = (STREAM_HANDLE*)h;
     CHECK_MAGIC(handle, MAGIC_STREAM_HANDLE);
     //read from stream
     disable_interrupts();
-    for(to_read = size_max; to_read && !rb_is_empty(&handle->stream->rb); --to_read)
-        *buf++ = handle->stream->data[rb_get(&handle->stream->rb)];
+    //ring is owned by acquired region
+    if (handle->stream->read_owner != NULL)
+    {
+        enable_interrupts();
+        return 0;
+    }
+    to_read = size_max - kstream_rb_get(handle->stream, buf, size_max);
+    buf += size_max - to_read;
     //read directly from input
     while (to_read && (writer = handle->stream->write_waiters) != NULL)
     {
@@ -273,6 +486,7 @@ unsigned int kstream_read_no_block(HANDLE h, char* buf, unsigned int size_max)
             buf += writer->size;
             //wakeup writer
             dlist_remove_head((DLIST**)&handle->stream->write_waiters);
+            KTRACE_INTERNAL(TRACE_STREAM_UNBLOCK, writer->process, writer);
             kprocess_wakeup(writer->process);
             writer->mode = STREAM_MODE_IDLE;
         }
@@ -288,21 +502,7 @@ unsigned int kstream_read_no_block(HANDLE h, char* buf, unsigned int size_max)
     }
     //push data to stream internally after read
     if (to_read < size_max)
-    {
-        to_push = rb_free(&handle->stream->rb);
-        while ((writer = handle->stream->write_waiters) != NULL && to_push)
-        {
-            for(; to_push && writer->size; --writer->size, --to_push)
-                handle->stream->data[rb_put(&handle->stream->rb)] = *writer->buf++;
-            //writed all from waiter? Wake him up.
-            if (!writer->size)
-            {
-                dlist_remove_head((DLIST**)&handle->stream->write_waiters);
-                kprocess_wakeup(writer->process);
-                writer->mode = STREAM_MODE_IDLE;
-            }
-        }
-    }
+        kstream_push_writers(handle->stream);
     enable_interrupts();
     return size_max - to_read;
 }
@@ -318,11 +518,125 @@ void kstream_read(HANDLE process, HANDLE h, char* buf, unsigned int size)
         handle->mode = STREAM_MODE_READ;
         kprocess_sleep(process, NULL, PROCESS_SYNC_STREAM, h);
         disable_interrupts();
+        KTRACE_INTERNAL(TRACE_STREAM_BLOCK, process, h);
         dlist_add_tail((DLIST**)&handle->stream->read_waiters, (DLIST*)handle);
         enable_interrupts();
     }
 }
 
+static STREAM* kstream_owner_check(HANDLE process, STREAM_HANDLE* handle)
+{
+    CHECK_MAGIC(handle, MAGIC_STREAM_HANDLE);
+    if (handle->stream == (STREAM*)INVALID_HANDLE)
+    {
+        error(ERROR_SYNC_OBJECT_DESTROYED);
+        return NULL;
+    }
+    if (handle->process != process)
+    {
+        error(ERROR_ACCESS_DENIED);
+        return NULL;
+    }
+    return handle->stream;
+}
+
+unsigned int kstream_acquire_read(HANDLE process, HANDLE h, char** ptr)
+{
+    RB rb;
+    unsigned int size;
+    STREAM_HANDLE* handle = (STREAM_HANDLE*)h;
+    STREAM* stream = kstream_owner_check(process, handle);
+    if (stream == NULL)
+        return 0;
+    disable_interrupts();
+    if (stream->read_owner != NULL && stream->read_owner != handle)
+    {
+        enable_interrupts();
+        error(ERROR_IN_PROGRESS);
+        return 0;
+    }
+    stream->read_owner = handle;
+    //just peek span, tail is moved on release
+    rb = stream->rb;
+    size = stream->rb.size;
+    *ptr = stream->read_ptr = stream->data + rb_get_span(&rb, &size);
+    stream->read_len = size;
+    enable_interrupts();
+    return size;
+}
+
+void kstream_release_read(HANDLE process, HANDLE h, unsigned int size)
+{
+    STREAM_HANDLE* handle = (STREAM_HANDLE*)h;
+    STREAM* stream = kstream_owner_check(process, handle);
+    if (stream == NULL)
+        return;
+    disable_interrupts();
+    //not acquired or flushed after acquire
+    if (stream->read_owner != handle || stream->data + stream->rb.tail != stream->read_ptr)
+    {
+        enable_interrupts();
+        error(ERROR_INVALID_STATE);
+        return;
+    }
+    stream->read_owner = NULL;
+    //tail can't be moved by others while acquired, so span starts at acquired pointer
+    if (size > stream->read_len)
+        size = stream->read_len;
+    rb_get_span(&stream->rb, &size);
+    kstream_sync(stream);
+    enable_interrupts();
+}
+
+unsigned int kstream_acquire_write(HANDLE process, HANDLE h, char** ptr)
+{
+    RB rb;
+    unsigned int size;
+    STREAM_HANDLE* handle = (STREAM_HANDLE*)h;
+    STREAM* stream = kstream_owner_check(process, handle);
+    if (stream == NULL)
+        return 0;
+    disable_interrupts();
+    if (stream->write_owner != NULL && stream->write_owner != handle)
+    {
+        enable_interrupts();
+        error(ERROR_IN_PROGRESS);
+        return 0;
+    }
+    stream->write_owner = handle;
+    //just peek span, head is moved on release
+    rb = stream->rb;
+    size = stream->rb.size;
+    *ptr = stream->write_ptr = stream->data + rb_put_span(&rb, &size);
+    stream->write_len = size;
+    enable_interrupts();
+    return size;
+}
+
+void kstream_release_write(HANDLE process, HANDLE h, unsigned int size)
+{
+    STREAM_HANDLE* handle = (STREAM_HANDLE*)h;
+    STREAM* stream = kstream_owner_check(process, handle);
+    if (stream == NULL)
+        return;
+    disable_interrupts();
+    //not acquired or flushed after acquire
+    if (stream->write_owner != handle || stream->data + stream->rb.head != stream->write_ptr)
+    {
+        enable_interrupts();
+        error(ERROR_INVALID_STATE);
+        return;
+    }
+    stream->write_owner = NULL;
+    //head can't be moved by others while acquired, so span starts at acquired pointer
+    if (size > stream->write_len)
+        size = stream->write_len;
+    rb_put_span(&stream->rb, &size);
+    kstream_sync(stream);
+    enable_interrupts();
+    kstream_check_inform(stream);
+}
+
 void kstream_flush(HANDLE s)
 {
     STREAM* stream = (STREAM*)s;
@@ -331,7 +645,10 @@ void kstream_flush(HANDLE s)
     stream->listener = INVALID_HANDLE;
     //flush stream
     disable_interrupts();
+    ksystime_timer_stop_internal(&stream->listener_timer);
     rb_clear(&stream->rb);
+    //acquired spans are not valid anymore. Release will fail
+    stream->read_owner = stream->write_owner = NULL;
     //flush waiters
     while ((handle = stream->write_waiters) != NULL)
     {
@@ -363,9 +680,11 @@ void kstream_destroy(HANDLE s)
     if (s == INVALID_HANDLE)
         return;
     CHECK_MAGIC(stream, MAGIC_STREAM);
-    CLEAR_MAGIC(stream);
+    disable_interrupts();
+    ksystime_timer_stop_internal(&stream->listener_timer);
+    enable_interrupts();
     kstream_destroy_handle(stream, (DLIST**)&stream->write_waiters);
     kstream_destroy_handle(stream, (DLIST**)&stream->read_waiters);
     kfree(stream->data);
-    kfree(stream);
+    kslab_free(&__KERNEL->slabs[KSLAB_STREAM], stream);
 }
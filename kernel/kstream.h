@@ -10,6 +10,9 @@
 #include "../userspace/ipc.h"
 #include "kprocess.h"
 
+//called from kernel
+void kstream_init();
+
 //called from kprocess
 void kstream_lock_release(HANDLE h, HANDLE process);
 
@@ -21,10 +24,16 @@ unsigned int kstream_get_size(HANDLE s);
 unsigned int kstream_get_free(HANDLE s);
 void kstream_listen(HANDLE process, HANDLE s, unsigned int param, HAL hal);
 void kstream_stop_listen(HANDLE process, HANDLE s);
+void kstream_listen_watermark(HANDLE process, HANDLE s, unsigned int size, unsigned int timeout_us);
 unsigned int kstream_write_no_block(HANDLE h, char* buf, unsigned int size_max);
 void kstream_write(HANDLE process, HANDLE h, char* buf, unsigned int size);
 unsigned int kstream_read_no_block(HANDLE h, char* buf, unsigned int size_max);
 void kstream_read(HANDLE process, HANDLE h, char* buf, unsigned int size);
+//zero-copy access to ring
+unsigned int kstream_acquire_read(HANDLE process, HANDLE h, char** ptr);
+void kstream_release_read(HANDLE process, HANDLE h, unsigned int size);
+unsigned int kstream_acquire_write(HANDLE process, HANDLE h, char** ptr);
+void kstream_release_write(HANDLE process, HANDLE h, unsigned int size);
 void kstream_flush(HANDLE s);
 void kstream_destroy(HANDLE s);
 
@@ -13,6 +13,8 @@
 #include "kstdlib.h"
 #include "kipc.h"
 #include "kprocess_private.h"
+#include "ktrace.h"
+#include "kslab.h"
 
 #define FREE_RUN                                        2000000
 
@@ -22,6 +24,10 @@ typedef struct {
     HANDLE owner;
     unsigned int param;
     HAL hal;
+    //zero for one-shot timer
+    SYSTIME period;
+    //periods, missed by consumer since last IPC
+    unsigned int overrun;
 } SOFT_TIMER;
 
 void hpet_start_stub(unsigned int value, void* param)
@@ -61,40 +67,206 @@ void ksystime_get_uptime(SYSTIME* res)
     enable_interrupts();
 }
 
+//called while IRQ disabled
+static void ksystime_hpet_arm(unsigned int usec)
+{
+    __KERNEL->uptime.usec += __KERNEL->cb_ktimer.elapsed(__KERNEL->cb_ktimer_param);
+    __KERNEL->cb_ktimer.stop(__KERNEL->cb_ktimer_param);
+    //already passed while re-arming
+    __KERNEL->hpet_value = usec > __KERNEL->uptime.usec ? usec - __KERNEL->uptime.usec : 1;
+    __KERNEL->cb_ktimer.start(__KERNEL->hpet_value, __KERNEL->cb_ktimer_param);
+}
+
+//called while IRQ disabled
+static KTIMER** ksystime_timer_bucket(SYSTIME* time)
+{
+    if (time->sec > __KERNEL->uptime.sec)
+        return &__KERNEL->timers_sec[time->sec % KTIMER_SEC_BUCKETS];
+    //overdue timers are always in first bucket
+    if (time->sec < __KERNEL->uptime.sec)
+        return &__KERNEL->timers[0];
+    return &__KERNEL->timers[time->usec / KTIMER_USEC_BUCKET_SIZE];
+}
+
+//called while IRQ disabled. Bucket is sorted by time, same time timers are in start order. Walk is from tail:
+//deadlines are mostly growing in start order, so generally it's not walking at all
+static void ksystime_timer_insert(KTIMER* timer)
+{
+    KTIMER* cur;
+    timer->head = ksystime_timer_bucket(&timer->time);
+    if (timer->head < __KERNEL->timers + KTIMER_USEC_BUCKETS)
+        __KERNEL->timers_map |= 1u << (timer->head - __KERNEL->timers);
+    timer->active = true;
+    if (*timer->head == NULL)
+    {
+        dlist_add_tail((DLIST**)timer->head, (DLIST*)timer);
+        return;
+    }
+    for (cur = (KTIMER*)(*timer->head)->list.prev; systime_compare(&timer->time, &cur->time) > 0; cur = (KTIMER*)cur->list.prev)
+    {
+        if (cur == *timer->head)
+        {
+            dlist_add_head((DLIST**)timer->head, (DLIST*)timer);
+            return;
+        }
+    }
+    dlist_add_after((DLIST**)timer->head, (DLIST*)cur, (DLIST*)timer);
+}
+
+//called while IRQ disabled. Earliest timer in [from, to] of bucket
+static KTIMER* ksystime_timer_find(KTIMER** head, SYSTIME* from, SYSTIME* to)
+{
+    DLIST_ENUM de;
+    KTIMER* cur;
+    dlist_enum_start((DLIST**)head, &de);
+    while (dlist_enum(&de, (DLIST**)&cur))
+    {
+        //sorted, rest are later
+        if (systime_compare(&cur->time, to) < 0)
+            break;
+        if (systime_compare(from, &cur->time) >= 0)
+            return cur;
+    }
+    return NULL;
+}
+
+//called while IRQ disabled. Earliest timer in [from, to] of all buckets, covering window
+static KTIMER* ksystime_timer_find_window(SYSTIME* from, SYSTIME* to)
+{
+    KTIMER *cur, *found;
+    unsigned int map, sec, count;
+    //this second. Usec buckets are sorted, first found is earliest
+    if (from->sec <= __KERNEL->uptime.sec)
+    {
+        map = __KERNEL->timers_map & ~((1u << (ksystime_timer_bucket(from) - __KERNEL->timers)) - 1);
+        if (to->sec == __KERNEL->uptime.sec)
+            map &= 0xffffffff >> (KTIMER_USEC_BUCKETS - 1 - to->usec / KTIMER_USEC_BUCKET_SIZE);
+        for (; map; map &= map - 1)
+            if ((found = ksystime_timer_find(&__KERNEL->timers[__builtin_ctz(map)], from, to)) != NULL)
+                return found;
+    }
+    //next seconds. Sec buckets are holding few wheel turns, so check every bucket in window
+    found = NULL;
+    sec = from->sec > __KERNEL->uptime.sec ? from->sec : __KERNEL->uptime.sec + 1;
+    for (count = 0; sec <= to->sec && count < KTIMER_SEC_BUCKETS; ++sec, ++count)
+    {
+        cur = ksystime_timer_find(&__KERNEL->timers_sec[sec % KTIMER_SEC_BUCKETS], from, to);
+        if (cur != NULL && (found == NULL || systime_compare(&cur->time, &found->time) > 0))
+            found = cur;
+    }
+    return found;
+}
+
+//called while IRQ disabled. Move deadline inside slack window to already scheduled expiry, so they will be shoot together.
+//If no one, align to slack, so timers with same slack will meet
+static void ksystime_timer_slack(SYSTIME* time, unsigned int slack_us)
+{
+    SYSTIME latest;
+    KTIMER* found;
+    us_to_systime(slack_us, &latest);
+    systime_add(time, &latest, &latest);
+    found = ksystime_timer_find_window(time, &latest);
+    if (found != NULL)
+    {
+        time->sec = found->time.sec;
+        time->usec = found->time.usec;
+        return;
+    }
+    if (slack_us < 1000000)
+        time->usec = ((time->usec + slack_us - 1) / slack_us) * slack_us;
+    else if (time->usec)
+        time->usec = 1000000;
+    if (time->usec >= 1000000)
+    {
+        ++time->sec;
+        time->usec = 0;
+    }
+}
+
+//called while IRQ disabled
+static void ksystime_timer_remove(KTIMER* timer)
+{
+    dlist_remove((DLIST**)timer->head, (DLIST*)timer);
+    if (*timer->head == NULL && timer->head < __KERNEL->timers + KTIMER_USEC_BUCKETS)
+        __KERNEL->timers_map &= ~(1u << (timer->head - __KERNEL->timers));
+    timer->active = false;
+}
+
+//called while IRQ disabled. Earliest timer is head of first non-empty usec bucket
+static KTIMER* ksystime_timer_first()
+{
+    if (__KERNEL->timers_map == 0)
+        return NULL;
+    return __KERNEL->timers[__builtin_ctz(__KERNEL->timers_map)];
+}
+
+//called while IRQ disabled on second change. Not shoot yet timers of last second are overdue now. Buckets are
+//sorted and following in time order, so appending keeps first bucket sorted. Normally all of them are already shoot
+static void ksystime_timer_overdue()
+{
+    KTIMER* cur;
+    unsigned int bucket;
+    for (bucket = 1; bucket < KTIMER_USEC_BUCKETS; ++bucket)
+    {
+        while ((cur = __KERNEL->timers[bucket]) != NULL)
+        {
+            dlist_remove_head((DLIST**)&__KERNEL->timers[bucket]);
+            cur->head = &__KERNEL->timers[0];
+            dlist_add_tail((DLIST**)&__KERNEL->timers[0], (DLIST*)cur);
+        }
+    }
+    __KERNEL->timers_map = __KERNEL->timers[0] != NULL ? 1 : 0;
+}
+
+//on second change. Timers of this second are in head of sorted sec bucket, next wheel turns are not touched.
+//One timer per IRQ disabled section
+static void ksystime_timer_cascade()
+{
+    KTIMER* cur;
+    KTIMER** head;
+    for (;;)
+    {
+        disable_interrupts();
+        head = &__KERNEL->timers_sec[__KERNEL->uptime.sec % KTIMER_SEC_BUCKETS];
+        if ((cur = *head) == NULL || cur->time.sec > __KERNEL->uptime.sec)
+        {
+            enable_interrupts();
+            break;
+        }
+        dlist_remove_head((DLIST**)head);
+        ksystime_timer_insert(cur);
+        enable_interrupts();
+    }
+}
+
 static inline void find_shoot_next()
 {
     volatile KTIMER* timers_to_shoot = NULL;
-    volatile KTIMER* cur;
+    KTIMER* cur;
     SYSTIME uptime;
 
     disable_interrupts();
-    while (__KERNEL->timers)
+    while ((cur = ksystime_timer_first()) != NULL)
     {
         ksystime_get_uptime_internal(&uptime);
-        if (systime_compare(&__KERNEL->timers->time, &uptime) >= 0)
+        if (systime_compare(&cur->time, &uptime) >= 0)
         {
-            cur = __KERNEL->timers;
-            cur->active = false;
-            dlist_remove_head((DLIST**)&__KERNEL->timers);
+            ksystime_timer_remove(cur);
             dlist_add_tail((DLIST**)&timers_to_shoot, (DLIST*)cur);
         }
         //add to this second events
-        else if (__KERNEL->timers->time.sec == uptime.sec)
+        else
         {
-            __KERNEL->uptime.usec += __KERNEL->cb_ktimer.elapsed(__KERNEL->cb_ktimer_param);
-            __KERNEL->cb_ktimer.stop(__KERNEL->cb_ktimer_param);
-            __KERNEL->hpet_value = __KERNEL->timers->time.usec - __KERNEL->uptime.usec;
-            __KERNEL->cb_ktimer.start(__KERNEL->hpet_value, __KERNEL->cb_ktimer_param);
+            ksystime_hpet_arm(cur->time.usec);
             break;
         }
-        else
-            break;
     }
     enable_interrupts();
     while (timers_to_shoot)
     {
-        cur = timers_to_shoot;
+        cur = (KTIMER*)timers_to_shoot;
         dlist_remove_head((DLIST**)&timers_to_shoot);
+        KTRACE(TRACE_TIMER, cur->callback, cur->param);
         cur->callback(cur->param);
     }
 }
@@ -107,8 +279,10 @@ void ksystime_second_pulse()
     __KERNEL->cb_ktimer.stop(__KERNEL->cb_ktimer_param);
     __KERNEL->cb_ktimer.start(FREE_RUN, __KERNEL->cb_ktimer_param);
     __KERNEL->uptime.usec = 0;
+    ksystime_timer_overdue();
     enable_interrupts();
 
+    ksystime_timer_cascade();
     find_shoot_next();
 }
 
@@ -143,37 +317,43 @@ void ksystime_hpet_setup(const CB_SVC_TIMER *cb_ktimer, void *cb_ktimer_param)
 
 void ksystime_timer_start_internal(KTIMER* timer, SYSTIME *time)
 {
-    SYSTIME uptime;
-    DLIST_ENUM de;
-    KTIMER* cur;
-    bool found = false;
-    ksystime_get_uptime(&uptime);
-    timer->time.sec = time->sec;
-    timer->time.usec = time->usec;
-    systime_add(&uptime, &timer->time, &timer->time);
+    //zero time is shoot right now
+    if (time->sec == 0 && time->usec == 0)
+    {
+        disable_interrupts();
+        ksystime_get_uptime_internal(&timer->time);
+        ksystime_timer_insert(timer);
+        enable_interrupts();
+        find_shoot_next();
+        return;
+    }
     disable_interrupts();
-    dlist_enum_start((DLIST**)&__KERNEL->timers, &de);
-    while (dlist_enum(&de, (DLIST**)&cur))
-        if (systime_compare(&cur->time, &timer->time) < 0)
-        {
-            dlist_add_before((DLIST**)&__KERNEL->timers, (DLIST*)cur, (DLIST*)timer);
-            found = true;
-            break;
-        }
-    if (!found)
-        dlist_add_tail((DLIST**)&__KERNEL->timers, (DLIST*)timer);
-    timer->active = true;
+    ksystime_timer_start_irq_disabled(timer, time);
     enable_interrupts();
-    find_shoot_next();
+}
+
+//called while IRQ disabled
+static void ksystime_timer_schedule(KTIMER* timer, SYSTIME* uptime)
+{
+    ksystime_timer_insert(timer);
+    //before armed in this second? Re-arm HPET. Time is in future, nothing to shoot right now
+    if (timer->time.sec == uptime->sec &&
+        (__KERNEL->hpet_value == 0 || timer->time.usec < __KERNEL->uptime.usec + __KERNEL->hpet_value))
+        ksystime_hpet_arm(timer->time.usec);
+}
+
+void ksystime_timer_start_irq_disabled(KTIMER* timer, SYSTIME* time)
+{
+    SYSTIME uptime;
+    ksystime_get_uptime_internal(&uptime);
+    systime_add(&uptime, time, &timer->time);
+    ksystime_timer_schedule(timer, &uptime);
 }
 
 void ksystime_timer_stop_internal(KTIMER* timer)
 {
     if (timer->active)
-    {
-        dlist_remove((DLIST**)&__KERNEL->timers, (DLIST*)timer);
-        timer->active = false;
-    }
+        ksystime_timer_remove(timer);
 }
 
 void ksystime_timer_init_internal(KTIMER* timer, void (*callback)(void*), void* param)
@@ -186,24 +366,55 @@ void ksystime_timer_init_internal(KTIMER* timer, void (*callback)(void*), void*
 void ksystime_soft_timer_timeout(void* param)
 {
     SOFT_TIMER* timer = (SOFT_TIMER*)param;
+    SYSTIME uptime;
     IPC ipc;
     ipc.process = timer->owner;
     ipc.cmd = HAL_CMD(timer->hal, IPC_TIMEOUT);
     ipc.param1 = timer->param;
     ipc.param2 = (unsigned int)timer;
+    ipc.param3 = 0;
+    disable_interrupts();
+    //periodic? Re-arm on absolute schedule, without drift
+    if (timer->period.sec || timer->period.usec)
+    {
+        ksystime_get_uptime_internal(&uptime);
+        systime_add(&timer->timer.time, &timer->period, &timer->timer.time);
+        //late for more than period. Skip missed
+        while (systime_compare(&timer->timer.time, &uptime) >= 0)
+        {
+            systime_add(&timer->timer.time, &timer->period, &timer->timer.time);
+            ++timer->overrun;
+        }
+        ksystime_timer_schedule(&timer->timer, &uptime);
+        //consumer still not received last timeout
+        if (kipc_queued(timer->owner, KERNEL_HANDLE, ipc.cmd, ipc.param1, ipc.param2))
+        {
+            ++timer->overrun;
+            enable_interrupts();
+            return;
+        }
+        ipc.param3 = timer->overrun;
+        timer->overrun = 0;
+    }
+    enable_interrupts();
     kipc_post(KERNEL_HANDLE, &ipc);
 }
 
+static void ksystime_soft_timer_ctor(void* obj)
+{
+    SOFT_TIMER* timer = (SOFT_TIMER*)obj;
+    ksystime_timer_init_internal(&timer->timer, ksystime_soft_timer_timeout, timer);
+}
+
 HANDLE ksystime_soft_timer_create(HANDLE process, HANDLE param, HAL hal)
 {
-    SOFT_TIMER* timer = kmalloc(sizeof(SOFT_TIMER));
+    SOFT_TIMER* timer = kslab_alloc(&__KERNEL->slabs[KSLAB_SOFT_TIMER]);
     if (timer == NULL)
         return INVALID_HANDLE;
-    DO_MAGIC(timer, MAGIC_TIMER);
     timer->owner = process;
     timer->param = param;
     timer->hal = hal;
-    ksystime_timer_init_internal(&timer->timer, ksystime_soft_timer_timeout, timer);
+    timer->period.sec = timer->period.usec = 0;
     return (HANDLE)timer;
 }
 
@@ -213,24 +424,65 @@ void ksystime_soft_timer_destroy(HANDLE t)
     if (t == INVALID_HANDLE)
         return;
     CHECK_MAGIC(timer, MAGIC_TIMER);
-    CLEAR_MAGIC(timer);
-    kfree(timer);
+    //object will be reused in constructed state
+    disable_interrupts();
+    ksystime_timer_stop_internal(&timer->timer);
+    enable_interrupts();
+    kslab_free(&__KERNEL->slabs[KSLAB_SOFT_TIMER], timer);
 }
 
 void ksystime_soft_timer_start(HANDLE t, SYSTIME* time)
 {
-    bool active;
+    ksystime_soft_timer_start_slack(t, time, 0);
+}
+
+void ksystime_soft_timer_start_slack(HANDLE t, SYSTIME* time, unsigned int slack_us)
+{
+    SYSTIME uptime;
     SOFT_TIMER* timer = (SOFT_TIMER*)t;
     CHECK_MAGIC(timer, MAGIC_TIMER);
     disable_interrupts();
-    active = timer->timer.active;
+    if (timer->timer.active)
+    {
+        enable_interrupts();
+        error(ERROR_ALREADY_CONFIGURED);
+        return;
+    }
+    timer->period.sec = timer->period.usec = 0;
+    if (slack_us == 0 || (time->sec == 0 && time->usec == 0))
+    {
+        enable_interrupts();
+        ksystime_timer_start_internal(&timer->timer, time);
+        return;
+    }
+    ksystime_get_uptime_internal(&uptime);
+    systime_add(&uptime, time, &timer->timer.time);
+    ksystime_timer_slack(&timer->timer.time, slack_us);
+    ksystime_timer_schedule(&timer->timer, &uptime);
     enable_interrupts();
-    if (active)
+}
+
+void ksystime_soft_timer_start_periodic(HANDLE t, SYSTIME* period)
+{
+    SOFT_TIMER* timer = (SOFT_TIMER*)t;
+    CHECK_MAGIC(timer, MAGIC_TIMER);
+    if (period->sec == 0 && period->usec == 0)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    disable_interrupts();
+    if (timer->timer.active)
     {
+        enable_interrupts();
         error(ERROR_ALREADY_CONFIGURED);
         return;
     }
-    ksystime_timer_start_internal(&timer->timer, time);
+    timer->period.sec = period->sec;
+    timer->period.usec = period->usec;
+    timer->overrun = 0;
+    ksystime_timer_start_irq_disabled(&timer->timer, period);
+    enable_interrupts();
 }
 
 void ksystime_soft_timer_start_ms(HANDLE t, unsigned int ms)
@@ -253,6 +505,7 @@ void ksystime_soft_timer_stop(HANDLE t)
     CHECK_MAGIC(timer, MAGIC_TIMER);
     //in case it shouting right now
     disable_interrupts();
+    timer->period.sec = timer->period.usec = 0;
     ksystime_timer_stop_internal(&timer->timer);
     enable_interrupts();
 }
@@ -262,4 +515,5 @@ void ksystime_init()
     __KERNEL->cb_ktimer.start = hpet_start_stub;
     __KERNEL->cb_ktimer.stop = hpet_stop_stub;
     __KERNEL->cb_ktimer.elapsed = hpet_elapsed_stub;
+    kslab_init(&__KERNEL->slabs[KSLAB_SOFT_TIMER], sizeof(SOFT_TIMER), KERNEL_SLAB, ksystime_soft_timer_ctor, KSLAB_MAGIC(SOFT_TIMER, MAGIC_TIMER));
 }
@@ -17,6 +17,8 @@ void ksystime_timer_start_internal(KTIMER* timer, SYSTIME* time);
 void ksystime_timer_stop_internal(KTIMER* timer);
 void ksystime_timer_init_internal(KTIMER* timer, void (*callback)(void*), void* param);
 void ksystime_get_uptime_internal(SYSTIME* res);
+//called while IRQ disabled. Time must be not zero
+void ksystime_timer_start_irq_disabled(KTIMER* timer, SYSTIME* time);
 
 //called from svc handler / exo drivers
 void ksystime_hpet_timeout();
@@ -27,6 +29,10 @@ void ksystime_hpet_setup(const CB_SVC_TIMER* cb_ktimer, void* cb_ktimer_param);
 HANDLE ksystime_soft_timer_create(HANDLE process, HANDLE param, HAL hal);
 void ksystime_soft_timer_destroy(HANDLE t);
 void ksystime_soft_timer_start(HANDLE t, SYSTIME* time);
+//deadline can be delayed up to slack_us to be shoot together with other timers
+void ksystime_soft_timer_start_slack(HANDLE t, SYSTIME* time, unsigned int slack_us);
+//re-armed by kernel every period. Missed periods are in param3 of IPC
+void ksystime_soft_timer_start_periodic(HANDLE t, SYSTIME* period);
 void ksystime_soft_timer_start_ms(HANDLE t, unsigned int ms);
 void ksystime_soft_timer_start_us(HANDLE t, unsigned int us);
 void ksystime_soft_timer_stop(HANDLE t);
@@ -0,0 +1,86 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "ktrace.h"
+#include "kernel.h"
+#include "ksystime.h"
+#include <string.h>
+
+#if (KERNEL_TRACE)
+
+void ktrace_init()
+{
+    rb_init(&__KERNEL->trace_rb, KERNEL_TRACE);
+    __KERNEL->trace_lost = 0;
+}
+
+void ktrace_internal(unsigned int event, unsigned int param1, unsigned int param2)
+{
+    TRACE* cur;
+    //don't overwrite, reader must know about gap
+    if (rb_is_full(&__KERNEL->trace_rb))
+    {
+        ++__KERNEL->trace_lost;
+        return;
+    }
+    cur = &__KERNEL->trace[rb_put(&__KERNEL->trace_rb)];
+    ksystime_get_uptime_internal(&cur->time);
+    cur->event = event;
+    cur->param1 = param1;
+    cur->param2 = param2;
+}
+
+void ktrace(unsigned int event, unsigned int param1, unsigned int param2)
+{
+    disable_interrupts();
+    ktrace_internal(event, param1, param2);
+    enable_interrupts();
+}
+
+unsigned int ktrace_read(TRACE* buf, unsigned int count)
+{
+    unsigned int i;
+    disable_interrupts();
+    for (i = 0; i < count; ++i)
+    {
+        if (!rb_is_empty(&__KERNEL->trace_rb))
+            memcpy(&buf[i], &__KERNEL->trace[rb_get(&__KERNEL->trace_rb)], sizeof(TRACE));
+        //events after buffered were lost
+        else if (__KERNEL->trace_lost)
+        {
+            ksystime_get_uptime_internal(&buf[i].time);
+            buf[i].event = TRACE_LOST;
+            buf[i].param1 = __KERNEL->trace_lost;
+            buf[i].param2 = 0;
+            __KERNEL->trace_lost = 0;
+        }
+        else
+            break;
+    }
+    enable_interrupts();
+    return i;
+}
+
+unsigned int ktrace_count()
+{
+    unsigned int count;
+    disable_interrupts();
+    count = rb_size(&__KERNEL->trace_rb);
+    //TRACE_LOST record
+    if (__KERNEL->trace_lost)
+        ++count;
+    enable_interrupts();
+    return count;
+}
+
+void ktrace_lost(unsigned int count)
+{
+    disable_interrupts();
+    __KERNEL->trace_lost += count;
+    enable_interrupts();
+}
+
+#endif //KERNEL_TRACE
@@ -0,0 +1,31 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef KTRACE_H
+#define KTRACE_H
+
+#include "kernel_config.h"
+#include "../userspace/trace.h"
+
+#if (KERNEL_TRACE)
+//called from startup
+void ktrace_init();
+//called while IRQ disabled
+void ktrace_internal(unsigned int event, unsigned int param1, unsigned int param2);
+void ktrace(unsigned int event, unsigned int param1, unsigned int param2);
+//called from svc
+unsigned int ktrace_read(TRACE* buf, unsigned int count);
+unsigned int ktrace_count();
+void ktrace_lost(unsigned int count);
+
+#define KTRACE(event, param1, param2)                       ktrace((event), (unsigned int)(param1), (unsigned int)(param2))
+#define KTRACE_INTERNAL(event, param1, param2)              ktrace_internal((event), (unsigned int)(param1), (unsigned int)(param2))
+#else
+#define KTRACE(event, param1, param2)
+#define KTRACE_INTERNAL(event, param1, param2)
+#endif //KERNEL_TRACE
+
+#endif // KTRACE_H
@@ -0,0 +1,71 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "../../userspace/process.h"
+#include "../../userspace/stream.h"
+#include "../../userspace/object.h"
+#include "../../userspace/svc.h"
+#include "../../userspace/ipc.h"
+#include "../../userspace/error.h"
+#include "../../userspace/posix/posix_driver.h"
+#include "posix_config.h"
+#include "sys_config.h"
+
+void posix_console();
+
+const REX __POSIX_CONSOLE = {
+    //name
+    "POSIX console",
+    //size
+    POSIX_CONSOLE_PROCESS_SIZE,
+    //priority - above any writer, so stream is drained before writer is blocked
+    90,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    posix_console
+};
+
+//print in place, without copy. On ring wrap rest is acquired on next pass
+static void posix_console_drain(HANDLE handle)
+{
+    char* ptr;
+    unsigned int len;
+    while (stream_acquire_read(handle, &ptr, &len) && len)
+    {
+        svc_call(SVC_PRINTD, (unsigned int)ptr, len, 0);
+        stream_release_read(handle, len);
+    }
+    stream_release_read(handle, 0);
+}
+
+void posix_console()
+{
+    IPC ipc;
+    HANDLE stream, handle;
+    stream = stream_create(POSIX_CONSOLE_STREAM_SIZE);
+    handle = stream_open(stream);
+    if (handle == INVALID_HANDLE)
+        return;
+    object_set(SYS_OBJ_STDOUT, stream);
+    stream_listen(stream, 0, HAL_UART);
+    for (;;)
+    {
+        ipc_read(&ipc);
+        switch (ipc.cmd)
+        {
+        case HAL_CMD(HAL_UART, IPC_STREAM_WRITE):
+            posix_console_drain(handle);
+            //listener is one-shot
+            stream_listen(stream, 0, HAL_UART);
+            break;
+        default:
+            error(ERROR_NOT_SUPPORTED);
+            break;
+        }
+        ipc_write(&ipc);
+    }
+}
@@ -0,0 +1,207 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "posix_disk.h"
+#include "../../userspace/error.h"
+#include "../../userspace/posix/posix_driver.h"
+#include <string.h>
+
+void posix_disk();
+
+const REX __POSIX_DISK = {
+    //name
+    "POSIX disk",
+    //size
+    POSIX_DISK_PROCESS_SIZE,
+    //priority - driver priority
+    91,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    posix_disk
+};
+
+//media itself is host memory, not part of RExOS SRAM
+static uint8_t __posix_disk[POSIX_DISK_SECTORS * POSIX_DISK_SECTOR_SIZE];
+
+static bool check_range(unsigned int sector, unsigned int size)
+{
+    if ((size == 0) || (size & (POSIX_DISK_SECTOR_SIZE - 1)))
+        return false;
+    if ((sector + size / POSIX_DISK_SECTOR_SIZE) > POSIX_DISK_SECTORS)
+        return false;
+    return true;
+}
+
+static inline void posix_disk_open(DISK_DRV* drv, HANDLE user)
+{
+    if (drv->active)
+    {
+        error(ERROR_ALREADY_CONFIGURED);
+        return;
+    }
+    drv->user = user;
+    drv->active = true;
+}
+
+static inline void posix_disk_close(DISK_DRV* drv)
+{
+    if (!drv->active)
+    {
+        error(ERROR_NOT_CONFIGURED);
+        return;
+    }
+    drv->active = false;
+}
+
+static void posix_disk_activity(DISK_DRV* drv, STORAGE_STACK* stack, unsigned int flags)
+{
+    if ((drv->activity != INVALID_HANDLE) && !(stack->flags & STORAGE_FLAG_IGNORE_ACTIVITY_ON_REQUEST))
+    {
+        ipc_post_inline(drv->activity, HAL_CMD(HAL_FLASH, STORAGE_NOTIFY_ACTIVITY), drv->user, flags, 0);
+        drv->activity = INVALID_HANDLE;
+    }
+}
+
+static inline void posix_disk_read(DISK_DRV* drv, HANDLE process, HANDLE user, IO* io, unsigned int size)
+{
+    STORAGE_STACK* stack = io_stack(io);
+    io_pop(io, sizeof(STORAGE_STACK));
+    if (!drv->active)
+    {
+        error(ERROR_NOT_CONFIGURED);
+        return;
+    }
+    if ((user != drv->user) || !check_range(stack->sector, size))
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    posix_disk_activity(drv, stack, 0);
+    io->data_size = 0;
+    io_data_append(io, __posix_disk + stack->sector * POSIX_DISK_SECTOR_SIZE, size);
+    io_complete(process, HAL_IO_CMD(HAL_FLASH, IPC_READ), user, io);
+    error(ERROR_SYNC);
+}
+
+static inline void posix_disk_write(DISK_DRV* drv, HANDLE process, HANDLE user, IO* io, unsigned int size)
+{
+    uint8_t* dst;
+    STORAGE_STACK* stack = io_stack(io);
+    io_pop(io, sizeof(STORAGE_STACK));
+    if (!drv->active)
+    {
+        error(ERROR_NOT_CONFIGURED);
+        return;
+    }
+    if ((user != drv->user) || !check_range(stack->sector, size))
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    posix_disk_activity(drv, stack, STORAGE_FLAG_WRITE);
+    dst = __posix_disk + stack->sector * POSIX_DISK_SECTOR_SIZE;
+    if ((stack->flags & STORAGE_MASK_MODE) == STORAGE_FLAG_ERASE_ONLY)
+        memset(dst, 0xff, size);
+    else
+    {
+        if (io->data_size < size)
+        {
+            error(ERROR_INVALID_PARAMS);
+            return;
+        }
+        if (stack->flags & STORAGE_FLAG_WRITE)
+            memcpy(dst, io_data(io), size);
+        if ((stack->flags & STORAGE_FLAG_VERIFY) && memcmp(dst, io_data(io), size))
+        {
+            error(ERROR_CRC);
+            return;
+        }
+    }
+    io_complete_ex(process, HAL_IO_CMD(HAL_FLASH, IPC_WRITE), user, io, size);
+    error(ERROR_SYNC);
+}
+
+static inline void posix_disk_get_media_descriptor(DISK_DRV* drv, HANDLE process, HANDLE user, IO* io)
+{
+    STORAGE_MEDIA_DESCRIPTOR* media;
+    if (!drv->active)
+    {
+        error(ERROR_NOT_CONFIGURED);
+        return;
+    }
+    if (user != drv->user)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    media = io_data(io);
+    media->num_sectors = POSIX_DISK_SECTORS;
+    media->num_sectors_hi = 0;
+    media->sector_size = POSIX_DISK_SECTOR_SIZE;
+    strcpy(STORAGE_MEDIA_SERIAL(media), "RAMDISK");
+    io->data_size = sizeof(STORAGE_MEDIA_DESCRIPTOR) + 7 + 1;
+    io_complete(process, HAL_IO_CMD(HAL_FLASH, STORAGE_GET_MEDIA_DESCRIPTOR), user, io);
+    error(ERROR_SYNC);
+}
+
+static inline void posix_disk_request_notify_activity(DISK_DRV* drv, HANDLE process)
+{
+    if (drv->activity != INVALID_HANDLE)
+    {
+        error(ERROR_ALREADY_CONFIGURED);
+        return;
+    }
+    drv->activity = process;
+    error(ERROR_SYNC);
+}
+
+static void posix_disk_request(DISK_DRV* drv, IPC* ipc)
+{
+    switch (HAL_ITEM(ipc->cmd))
+    {
+    case IPC_OPEN:
+        posix_disk_open(drv, (HANDLE)ipc->param1);
+        break;
+    case IPC_CLOSE:
+        posix_disk_close(drv);
+        break;
+    case IPC_READ:
+        posix_disk_read(drv, ipc->process, (HANDLE)ipc->param1, (IO*)ipc->param2, ipc->param3);
+        break;
+    case IPC_WRITE:
+        posix_disk_write(drv, ipc->process, (HANDLE)ipc->param1, (IO*)ipc->param2, ipc->param3);
+        break;
+    case IPC_FLUSH:
+        //nothing is cached
+        if (!drv->active)
+            error(ERROR_NOT_CONFIGURED);
+        break;
+    case STORAGE_GET_MEDIA_DESCRIPTOR:
+        posix_disk_get_media_descriptor(drv, ipc->process, (HANDLE)ipc->param1, (IO*)ipc->param2);
+        break;
+    case STORAGE_NOTIFY_ACTIVITY:
+        posix_disk_request_notify_activity(drv, ipc->process);
+        break;
+    default:
+        error(ERROR_NOT_SUPPORTED);
+        break;
+    }
+}
+
+void posix_disk()
+{
+    IPC ipc;
+    DISK_DRV drv;
+    drv.user = drv.activity = INVALID_HANDLE;
+    drv.active = false;
+    for (;;)
+    {
+        ipc_read(&ipc);
+        posix_disk_request(&drv, &ipc);
+        ipc_write(&ipc);
+    }
+}
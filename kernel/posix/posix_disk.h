@@ -0,0 +1,26 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef POSIX_DISK_H
+#define POSIX_DISK_H
+
+/*
+    POSIX host RAM disk. Storage protocol, as on flash and SD/MMC drivers. Content is lost on exit.
+*/
+
+#include "../../userspace/process.h"
+#include "../../userspace/storage.h"
+#include "posix_config.h"
+#include <stdbool.h>
+
+#define POSIX_DISK_SECTOR_SIZE              512
+
+typedef struct {
+    HANDLE user, activity;
+    bool active;
+} DISK_DRV;
+
+#endif // POSIX_DISK_H
@@ -0,0 +1,260 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "posix_eth.h"
+#include "../../userspace/object.h"
+#include "../../userspace/error.h"
+#include "../../userspace/posix/posix_driver.h"
+#include <string.h>
+
+void posix_eth();
+
+const REX __POSIX_ETH = {
+    //name
+    "POSIX ETH",
+    //size
+    POSIX_ETH_PROCESS_SIZE,
+    //priority - driver priority
+    91,
+    //flags
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    //function
+    posix_eth
+};
+
+//ports are wired in pairs: 0-1, 2-3, etc
+#define POSIX_ETH_PEER(port)                ((port) ^ 1)
+
+static inline bool posix_eth_connected(POSIX_ETH_PORT* port)
+{
+    return (port->conn != ETH_NO_LINK) && (port->conn != ETH_REMOTE_FAULT);
+}
+
+static void posix_eth_flush_port(ETH_DRV* drv, unsigned int port)
+{
+    POSIX_ETH_PORT* p = &drv->ports[port];
+    unsigned int i;
+    for (i = 0; i < p->rx_count; ++i)
+        io_complete_ex(p->tcpip, HAL_IO_CMD(HAL_ETH, IPC_READ), port, p->rx[i], ERROR_IO_CANCELLED);
+    for (i = 0; i < p->tx_count; ++i)
+        io_complete_ex(p->tcpip, HAL_IO_CMD(HAL_ETH, IPC_WRITE), port, p->tx[i], ERROR_IO_CANCELLED);
+    p->rx_count = p->tx_count = 0;
+}
+
+static void posix_eth_link_changed(ETH_DRV* drv, unsigned int port, ETH_CONN_TYPE conn)
+{
+    POSIX_ETH_PORT* p = &drv->ports[port];
+    if (p->conn == conn)
+        return;
+    p->conn = conn;
+    ipc_post_inline(p->tcpip, HAL_CMD(HAL_ETH, ETH_NOTIFY_LINK_CHANGED), 0, conn, 0);
+    if (!posix_eth_connected(p))
+        posix_eth_flush_port(drv, port);
+}
+
+//move frames from port TX to peer RX, while both are present
+static void posix_eth_wire(ETH_DRV* drv, unsigned int port)
+{
+    POSIX_ETH_PORT* src = &drv->ports[port];
+    POSIX_ETH_PORT* dst = &drv->ports[POSIX_ETH_PEER(port)];
+    IO* tx;
+    IO* rx;
+    while (src->tx_count && dst->rx_count)
+    {
+        tx = src->tx[0];
+        memmove(src->tx, src->tx + 1, (--src->tx_count) * sizeof(IO*));
+        //frame is not fitting in RX buffer. Like on real wire, it's lost
+        if (tx->data_size <= dst->rx_size[0])
+        {
+            rx = dst->rx[0];
+            memmove(dst->rx, dst->rx + 1, (--dst->rx_count) * sizeof(IO*));
+            memmove(dst->rx_size, dst->rx_size + 1, dst->rx_count * sizeof(unsigned int));
+            rx->data_size = 0;
+            io_data_append(rx, io_data(tx), tx->data_size);
+            io_complete(dst->tcpip, HAL_IO_CMD(HAL_ETH, IPC_READ), POSIX_ETH_PEER(port), rx);
+        }
+        io_complete(src->tcpip, HAL_IO_CMD(HAL_ETH, IPC_WRITE), port, tx);
+    }
+}
+
+static inline void posix_eth_open(ETH_DRV* drv, unsigned int port, ETH_CONN_TYPE conn, HANDLE tcpip)
+{
+    unsigned int peer = POSIX_ETH_PEER(port);
+    if (port >= POSIX_ETH_PORTS || peer >= POSIX_ETH_PORTS)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    if (drv->ports[port].tcpip != INVALID_HANDLE)
+    {
+        error(ERROR_ALREADY_CONFIGURED);
+        return;
+    }
+    drv->ports[port].tcpip = tcpip;
+    //wire is full duplex, requested mode is ignored
+    if (drv->ports[peer].tcpip != INVALID_HANDLE)
+    {
+        posix_eth_link_changed(drv, port, ETH_100_FULL);
+        posix_eth_link_changed(drv, peer, ETH_100_FULL);
+    }
+}
+
+static inline void posix_eth_close(ETH_DRV* drv, unsigned int port)
+{
+    if (port >= POSIX_ETH_PORTS || drv->ports[port].tcpip == INVALID_HANDLE)
+    {
+        error(ERROR_NOT_CONFIGURED);
+        return;
+    }
+    posix_eth_flush_port(drv, port);
+    drv->ports[port].conn = ETH_NO_LINK;
+    drv->ports[port].tcpip = INVALID_HANDLE;
+    if (drv->ports[POSIX_ETH_PEER(port)].tcpip != INVALID_HANDLE)
+        posix_eth_link_changed(drv, POSIX_ETH_PEER(port), ETH_NO_LINK);
+}
+
+static inline void posix_eth_flush(ETH_DRV* drv, unsigned int port)
+{
+    if (port >= POSIX_ETH_PORTS || drv->ports[port].tcpip == INVALID_HANDLE)
+    {
+        error(ERROR_NOT_CONFIGURED);
+        return;
+    }
+    posix_eth_flush_port(drv, port);
+}
+
+static inline void posix_eth_read(ETH_DRV* drv, IPC* ipc)
+{
+    POSIX_ETH_PORT* p;
+    if (ipc->param1 >= POSIX_ETH_PORTS)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    p = &drv->ports[ipc->param1];
+    if (!posix_eth_connected(p))
+    {
+        error(ERROR_NOT_ACTIVE);
+        return;
+    }
+    if (p->rx_count >= POSIX_ETH_BUFFERS)
+    {
+        error(ERROR_IN_PROGRESS);
+        return;
+    }
+    p->rx_size[p->rx_count] = ipc->param3;
+    p->rx[p->rx_count++] = (IO*)ipc->param2;
+    posix_eth_wire(drv, POSIX_ETH_PEER(ipc->param1));
+    error(ERROR_SYNC);
+}
+
+static inline void posix_eth_write(ETH_DRV* drv, IPC* ipc)
+{
+    POSIX_ETH_PORT* p;
+    if (ipc->param1 >= POSIX_ETH_PORTS)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    p = &drv->ports[ipc->param1];
+    if (!posix_eth_connected(p))
+    {
+        error(ERROR_NOT_ACTIVE);
+        return;
+    }
+    if (p->tx_count >= POSIX_ETH_BUFFERS)
+    {
+        error(ERROR_IN_PROGRESS);
+        return;
+    }
+    //not chained process: IO is already linearized by kernel
+    p->tx[p->tx_count++] = (IO*)ipc->param2;
+    posix_eth_wire(drv, ipc->param1);
+    error(ERROR_SYNC);
+}
+
+static inline void posix_eth_set_mac(ETH_DRV* drv, unsigned int port, unsigned int param2, unsigned int param3)
+{
+    if (port >= POSIX_ETH_PORTS)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    drv->ports[port].mac.u32.hi = param2;
+    drv->ports[port].mac.u32.lo = (uint16_t)param3;
+}
+
+static inline void posix_eth_get_mac(ETH_DRV* drv, IPC* ipc)
+{
+    if (ipc->param1 >= POSIX_ETH_PORTS)
+    {
+        error(ERROR_INVALID_PARAMS);
+        return;
+    }
+    ipc->param2 = drv->ports[ipc->param1].mac.u32.hi;
+    ipc->param3 = drv->ports[ipc->param1].mac.u32.lo;
+}
+
+static void posix_eth_init(ETH_DRV* drv)
+{
+    unsigned int i;
+    for (i = 0; i < POSIX_ETH_PORTS; ++i)
+    {
+        drv->ports[i].tcpip = INVALID_HANDLE;
+        drv->ports[i].conn = ETH_NO_LINK;
+        drv->ports[i].mac.u32.hi = drv->ports[i].mac.u32.lo = 0;
+        drv->ports[i].rx_count = drv->ports[i].tx_count = 0;
+    }
+}
+
+static void posix_eth_request(ETH_DRV* drv, IPC* ipc)
+{
+    switch (HAL_ITEM(ipc->cmd))
+    {
+    case IPC_OPEN:
+        posix_eth_open(drv, ipc->param1, ipc->param2, ipc->process);
+        break;
+    case IPC_CLOSE:
+        posix_eth_close(drv, ipc->param1);
+        break;
+    case IPC_FLUSH:
+        posix_eth_flush(drv, ipc->param1);
+        break;
+    case IPC_READ:
+        posix_eth_read(drv, ipc);
+        break;
+    case IPC_WRITE:
+        posix_eth_write(drv, ipc);
+        break;
+    case ETH_SET_MAC:
+        posix_eth_set_mac(drv, ipc->param1, ipc->param2, ipc->param3);
+        break;
+    case ETH_GET_MAC:
+        posix_eth_get_mac(drv, ipc);
+        break;
+    case ETH_GET_HEADER_SIZE:
+        //no DMA header
+        ipc->param2 = 0;
+        break;
+    default:
+        error(ERROR_NOT_SUPPORTED);
+        break;
+    }
+}
+
+void posix_eth()
+{
+    IPC ipc;
+    ETH_DRV drv;
+    posix_eth_init(&drv);
+    object_set_self(SYS_OBJ_ETH);
+    for (;;)
+    {
+        ipc_read(&ipc);
+        posix_eth_request(&drv, &ipc);
+        ipc_write(&ipc);
+    }
+}
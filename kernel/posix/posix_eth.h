@@ -0,0 +1,41 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef POSIX_ETH_H
+#define POSIX_ETH_H
+
+/*
+    POSIX host virtual Ethernet. Ports are connected by wire: frame, sent on one port, is received on other.
+    Link is up, while both ports are open. Frame is kept in TX, until peer gives RX buffer.
+*/
+
+#include "../../userspace/process.h"
+#include "../../userspace/eth.h"
+#include "../../userspace/io.h"
+#include "posix_config.h"
+#include "sys_config.h"
+
+#if (ETH_DOUBLE_BUFFERING)
+#define POSIX_ETH_BUFFERS                   2
+#else
+#define POSIX_ETH_BUFFERS                   1
+#endif //ETH_DOUBLE_BUFFERING
+
+typedef struct {
+    IO* tx[POSIX_ETH_BUFFERS];
+    IO* rx[POSIX_ETH_BUFFERS];
+    unsigned int rx_size[POSIX_ETH_BUFFERS];
+    unsigned int tx_count, rx_count;
+    ETH_CONN_TYPE conn;
+    HANDLE tcpip;
+    MAC mac;
+} POSIX_ETH_PORT;
+
+typedef struct {
+    POSIX_ETH_PORT ports[POSIX_ETH_PORTS];
+} ETH_DRV;
+
+#endif // POSIX_ETH_H
@@ -29,7 +29,7 @@ const REX __STM32_ETH = {
     //priority - driver priority
     91,
     //flags
-    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME,
+    PROCESS_FLAGS_ACTIVE | REX_FLAG_PERSISTENT_NAME | REX_FLAG_IO_CHAIN,
     //function
     stm32_eth
 };
@@ -253,18 +253,19 @@ static inline void stm32_eth_open(ETH_DRV* drv, unsigned int phy_addr, ETH_CONN_
     drv->rx_des[1].size = ETH_RDES_RCH;
     drv->rx_des[1].buf2_ndes = &drv->rx_des[0];
 
-    drv->tx_des[0].ctl = ETH_TDES_TCH | ETH_TDES_IC;
-    drv->tx_des[0].buf2_ndes = &drv->tx_des[1];
-    drv->tx_des[1].ctl = ETH_TDES_TCH | ETH_TDES_IC;
-    drv->tx_des[1].buf2_ndes = &drv->tx_des[0];
+    //tx is in ring mode, buf2 is used for IO chain fragment
+    drv->tx_des[0].ctl = ETH_TDES_IC;
+    drv->tx_des[0].buf2_ndes = NULL;
+    drv->tx_des[1].ctl = ETH_TDES_TER | ETH_TDES_IC;
+    drv->tx_des[1].buf2_ndes = NULL;
 
     drv->cur_rx = drv->cur_tx = 0;
 #else
     drv->rx_des.ctl = 0;
     drv->rx_des.size = ETH_RDES_RCH;
     drv->rx_des.buf2_ndes = &drv->rx_des;
-    drv->tx_des.ctl = ETH_TDES_TCH;
-    drv->tx_des.buf2_ndes = &drv->tx_des;
+    drv->tx_des.ctl = ETH_TDES_TER;
+    drv->tx_des.buf2_ndes = NULL;
 #endif
     ETH->DMATDLAR = (unsigned int)&drv->tx_des;
     ETH->DMARDLAR = (unsigned int)&drv->rx_des;
@@ -354,6 +355,27 @@ static inline void stm32_eth_read(ETH_DRV* drv, IPC* ipc)
     error(ERROR_SYNC);
 }
 
+static bool stm32_eth_tx_setup(ETH_DESCRIPTORS* des, IO* io)
+{
+    IO_FRAGMENT* fragment;
+    //descriptor holds user data and single chain fragment, rest is copied
+    if ((io->chain_size > 1) && !io_linearize(io))
+    {
+        error(ERROR_IO_BUFFER_TOO_SMALL);
+        return false;
+    }
+    des->buf1 = io_data(io);
+    des->size = ((io->data_size << ETH_TDES_TBS1_POS) & ETH_TDES_TBS1_MASK);
+    des->buf2_ndes = NULL;
+    if (io->chain_size)
+    {
+        fragment = io_chain_fragment(io, 0);
+        des->buf2_ndes = fragment->ptr;
+        des->size |= ((fragment->len << ETH_TDES_TBS2_POS) & ETH_TDES_TBS2_MASK);
+    }
+    return true;
+}
+
 static inline void stm32_eth_write(ETH_DRV* drv, IPC* ipc)
 {
     IO* io = (IO*)ipc->param2;
@@ -375,9 +397,9 @@ static inline void stm32_eth_write(ETH_DRV* drv, IPC* ipc)
         error(ERROR_IN_PROGRESS);
         return;
     }
-    drv->tx_des[i].buf1 = io_data(io);
-    drv->tx_des[i].size = ((io->data_size << ETH_TDES_TBS1_POS) & ETH_TDES_TBS1_MASK);
-    drv->tx_des[i].ctl = ETH_TDES_TCH | ETH_TDES_FS | ETH_TDES_LS | ETH_TDES_IC;
+    if (!stm32_eth_tx_setup(&drv->tx_des[i], io))
+        return;
+    drv->tx_des[i].ctl = (i ? ETH_TDES_TER : 0) | ETH_TDES_FS | ETH_TDES_LS | ETH_TDES_IC;
     __disable_irq();
     drv->tx[i] = io;
     //give descriptor to DMA
@@ -389,11 +411,11 @@ static inline void stm32_eth_write(ETH_DRV* drv, IPC* ipc)
         error(ERROR_IN_PROGRESS);
         return;
     }
-    drv->tx_des.buf1 = io_data(io);
+    if (!stm32_eth_tx_setup(&drv->tx_des, io))
+        return;
     drv->tx = io;
-    drv->tx_des.size = ((io->data_size << ETH_TDES_TBS1_POS) & ETH_TDES_TBS1_MASK);
     //give descriptor to DMA
-    drv->tx_des.ctl = ETH_TDES_TCH | ETH_TDES_FS | ETH_TDES_LS | ETH_TDES_IC;
+    drv->tx_des.ctl = ETH_TDES_TER | ETH_TDES_FS | ETH_TDES_LS | ETH_TDES_IC;
     drv->tx_des.ctl |= ETH_TDES_OWN;
 #endif
     //enable and poll DMA. Value is doesn't matter
@@ -9,22 +9,31 @@
 #include "../userspace/process.h"
 #include <string.h>
 
+#if (KERNEL_ALLOC_PROFILING)
+#define SLOT_CALLER_SIZE                                        (sizeof(void*))
+#else
+#define SLOT_CALLER_SIZE                                        (0)
+#endif //KERNEL_ALLOC_PROFILING
+
 #if (KERNEL_RANGE_CHECKING)
 
-#define SLOT_HEADER_SIZE                                        (sizeof(void*) + sizeof(unsigned int))
+#define SLOT_HEADER_SIZE                                        (sizeof(void*) + SLOT_CALLER_SIZE + sizeof(unsigned int))
 #define SLOT_FOOTER_SIZE                                        (sizeof (unsigned int))
 
 #else
 
-#define SLOT_HEADER_SIZE                                        (sizeof(void*))
+#define SLOT_HEADER_SIZE                                        (sizeof(void*) + SLOT_CALLER_SIZE)
 #define SLOT_FOOTER_SIZE                                        (0)
 
 #endif //(KERNEL_RANGE_CHECKING)
 
-#define MIN_SLOT_FULL_SIZE                                        (SLOT_HEADER_SIZE + sizeof(int) + SLOT_FOOTER_SIZE)
+//free slot is holding next free pointer
+#define MIN_SLOT_FULL_SIZE                                        (SLOT_HEADER_SIZE + sizeof(void*) + SLOT_FOOTER_SIZE)
 
 #define NEXT_SLOT(ptr)                                            (*(void**)((unsigned int)(ptr) - SLOT_HEADER_SIZE))
 #define NEXT_FREE(ptr)                                            (*(void**)(ptr))
+//allocation site, right after next slot pointer
+#define SLOT_CALLER(ptr)                                          (*(void**)((unsigned int)(ptr) - SLOT_HEADER_SIZE + sizeof(void*)))
 #define NUM(ptr)                                                    (unsigned int)(ptr)
 #define ALIGN_SIZE                                                (sizeof(int))
 #define ALIGN(var)                                                (((var) + (ALIGN_SIZE - 1)) & ~(ALIGN_SIZE - 1))
@@ -58,7 +67,7 @@ static const unsigned int RANGE_MARK_POOL_END =                   0xeeeeeeee;
         malloc
 
         data slot:
-        SLOT_HEADER        <--- next slot (pointing to data AFTER SLOT_HEADER)
+        SLOT_HEADER        <--- next slot (pointing to data AFTER SLOT_HEADER), caller (KERNEL_ALLOC_PROFILING only)
         <data>            <--- returned pointer
         <align to sizeof(int)>
 
@@ -72,15 +81,464 @@ static const unsigned int RANGE_MARK_POOL_END =                   0xeeeeeeee;
 
 */
 
+#if (KERNEL_ALLOC_PROFILING)
+
+/*
+        allocation profiling. Table of sites is placed on start of pool data, before first slot.
+
+        Every used slot is tagged by caller. Caller is set by malloc wrapper in pool->caller,
+        otherwise return address of pool_malloc is used
+*/
+
+static void* pool_profile_init(POOL* pool, void* data)
+{
+    POOL_PROFILE* profile = (POOL_PROFILE*)ALIGN(NUM(data));
+    memset(profile, 0, sizeof(POOL_PROFILE));
+    pool->profile = profile;
+    pool->caller = NULL;
+    return (void*)(NUM(profile) + sizeof(POOL_PROFILE));
+}
+
+static POOL_SITE* pool_profile_site(POOL* pool, void* caller)
+{
+    int i;
+    POOL_SITE* site = ((POOL_PROFILE*)pool->profile)->sites;
+    for (i = 0; i < KERNEL_ALLOC_PROFILING - 1; ++i, ++site)
+    {
+        if (site->caller == caller)
+            return site;
+        if (site->caller == NULL)
+        {
+            site->caller = caller;
+            return site;
+        }
+    }
+    //table is full, last entry is for all others
+    return site;
+}
+
+static unsigned int pool_profile_bucket(size_t size)
+{
+    unsigned int bucket;
+    if (size <= POOL_PROFILE_MIN_SIZE)
+        return 0;
+    bucket = 32 - __builtin_clz(size - 1) - 4;
+    return bucket < POOL_PROFILE_BUCKETS ? bucket : POOL_PROFILE_BUCKETS - 1;
+}
+
+static void pool_profile_alloc(POOL* pool, void* ptr, void* caller)
+{
+    POOL_SITE* site = pool_profile_site(pool, caller);
+    size_t size = pool_slot_size(pool, ptr);
+    SLOT_CALLER(ptr) = caller;
+    site->live += size;
+    ++site->count;
+    if (site->live > site->peak)
+        site->peak = site->live;
+    ++((POOL_PROFILE*)pool->profile)->sizes[pool_profile_bucket(size)];
+}
+
+static void pool_profile_free(POOL* pool, void* ptr)
+{
+    POOL_SITE* site = pool_profile_site(pool, SLOT_CALLER(ptr));
+    size_t size = pool_slot_size(pool, ptr);
+    site->live -= size;
+    --site->count;
+    --((POOL_PROFILE*)pool->profile)->sizes[pool_profile_bucket(size)];
+}
+
+#else
+
+static inline void* pool_profile_init(POOL* pool, void* data)
+{
+    pool->profile = NULL;
+    pool->caller = NULL;
+    return data;
+}
+
+#endif //KERNEL_ALLOC_PROFILING
+
+#if (KERNEL_POOL_TLSF)
+
+/*
+        TLSF mode. Two-level segregated fit: free slots are in lists by size class, found by bitmaps in O(1)
+
+        Slot layout is same, as above. Low bits of next slot pointer are used as flags:
+        TLSF_FLAG_FREE          - slot is free
+        TLSF_FLAG_PREV_FREE     - slot before is free, pointer to it is in last word of it's data
+
+        free slot:
+        SLOT_HEADER        <--- next slot | flags
+        <next free>
+        <prev free>
+        <free bytes>
+        <this slot>        <--- back pointer for slot after
+*/
+
+#define TLSF_FLAG_FREE                                          (1 << 0)
+#define TLSF_FLAG_PREV_FREE                                     (1 << 1)
+#define TLSF_FLAGS                                              (TLSF_FLAG_FREE | TLSF_FLAG_PREV_FREE)
+
+#define TLSF_SL_LOG2                                            2
+#define TLSF_SL_COUNT                                           (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT                                           (TLSF_SL_LOG2 + 2)
+#define TLSF_SMALL_SIZE                                         (1 << TLSF_FL_SHIFT)
+//allocations up to 16MB
+#define TLSF_FL_MAX                                             24
+#define TLSF_FL_COUNT                                           (TLSF_FL_MAX - TLSF_FL_SHIFT + 2)
+
+//next free, prev free, back pointer
+#define TLSF_MIN_DATA                                           (3 * sizeof(void*))
+#define TLSF_MIN_SLOT_FULL_SIZE                                 (SLOT_HEADER_SIZE + TLSF_MIN_DATA + SLOT_FOOTER_SIZE)
+
+#define TLSF_FLAGS_OF(ptr)                                      (NUM(NEXT_SLOT(ptr)) & TLSF_FLAGS)
+#define TLSF_NEXT(ptr)                                          ((void*)(NUM(NEXT_SLOT(ptr)) & ~TLSF_FLAGS))
+#define TLSF_SET_NEXT(ptr, next, flags)                         NEXT_SLOT(ptr) = (void*)(NUM(next) | (flags))
+#define TLSF_PREV_FREE(ptr)                                     (*((void**)(ptr) + 1))
+#define TLSF_BACK(ptr)                                          (*(void**)(NUM(ptr) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE - sizeof(void*)))
+#define TLSF_SIZE(ptr)                                          (NUM(TLSF_NEXT(ptr)) - NUM(ptr) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE)
+
+#if (KERNEL_RANGE_CHECKING)
+
+#define TLSF_SET_MARK(ptr)                                      *((unsigned int*)(ptr) - 1) = RANGE_MARK; \
+                                                                    if (TLSF_NEXT(ptr) != NULL) \
+                                                                        *(unsigned int*)(NUM(TLSF_NEXT(ptr)) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE) = RANGE_MARK_END; \
+                                                                    else \
+                                                                        *(unsigned int*)(ptr) = RANGE_MARK_POOL_END
+
+#else
+
+#define TLSF_SET_MARK(ptr)
+
+#endif //(KERNEL_RANGE_CHECKING)
+
+typedef struct {
+    unsigned int fl_map;
+    uint8_t sl_map[TLSF_FL_COUNT];
+    void* heads[TLSF_FL_COUNT][TLSF_SL_COUNT];
+} TLSF;
+
+static void tlsf_mapping(size_t size, int* fl, int* sl)
+{
+    int f;
+    if (size < TLSF_SMALL_SIZE)
+    {
+        *fl = 0;
+        *sl = size >> (TLSF_FL_SHIFT - TLSF_SL_LOG2);
+        return;
+    }
+    f = 31 - __builtin_clz(size);
+    //huge slots are all in last class
+    if (f > TLSF_FL_MAX)
+    {
+        *fl = TLSF_FL_COUNT - 1;
+        *sl = TLSF_SL_COUNT - 1;
+        return;
+    }
+    *fl = f - TLSF_FL_SHIFT + 1;
+    *sl = (size >> (f - TLSF_SL_LOG2)) & (TLSF_SL_COUNT - 1);
+}
+
+//round up to size class, so any slot in class is fit
+static bool tlsf_round(size_t* size)
+{
+    int f;
+    if (*size >= TLSF_SMALL_SIZE)
+    {
+        f = 31 - __builtin_clz(*size);
+        if (f >= TLSF_FL_MAX)
+            return false;
+        *size += (1 << (f - TLSF_SL_LOG2)) - 1;
+    }
+    return true;
+}
+
+static void* tlsf_find(TLSF* tlsf, int fl, int sl)
+{
+    unsigned int map = tlsf->sl_map[fl] & (~0u << sl);
+    if (map == 0)
+    {
+        map = tlsf->fl_map & (~0u << (fl + 1));
+        if (map == 0)
+            return NULL;
+        fl = __builtin_ctz(map);
+        map = tlsf->sl_map[fl];
+    }
+    return tlsf->heads[fl][__builtin_ctz(map)];
+}
+
+static void tlsf_insert(TLSF* tlsf, void* ptr)
+{
+    int fl, sl;
+    tlsf_mapping(TLSF_SIZE(ptr), &fl, &sl);
+    NEXT_FREE(ptr) = tlsf->heads[fl][sl];
+    TLSF_PREV_FREE(ptr) = NULL;
+    if (tlsf->heads[fl][sl] != NULL)
+        TLSF_PREV_FREE(tlsf->heads[fl][sl]) = ptr;
+    tlsf->heads[fl][sl] = ptr;
+    tlsf->fl_map |= 1 << fl;
+    tlsf->sl_map[fl] |= 1 << sl;
+}
+
+static void tlsf_remove(TLSF* tlsf, void* ptr)
+{
+    int fl, sl;
+    if (NEXT_FREE(ptr) != NULL)
+        TLSF_PREV_FREE(NEXT_FREE(ptr)) = TLSF_PREV_FREE(ptr);
+    if (TLSF_PREV_FREE(ptr) != NULL)
+    {
+        NEXT_FREE(TLSF_PREV_FREE(ptr)) = NEXT_FREE(ptr);
+        return;
+    }
+    tlsf_mapping(TLSF_SIZE(ptr), &fl, &sl);
+    tlsf->heads[fl][sl] = NEXT_FREE(ptr);
+    if (tlsf->heads[fl][sl] == NULL)
+    {
+        tlsf->sl_map[fl] &= ~(1 << sl);
+        if (tlsf->sl_map[fl] == 0)
+            tlsf->fl_map &= ~(1 << fl);
+    }
+}
+
+//merge with free neighbours and put to free list
+static void tlsf_release(TLSF* tlsf, void* ptr)
+{
+    void* next = TLSF_NEXT(ptr);
+    void* prev;
+    //next is also free?
+    if (TLSF_FLAGS_OF(next) & TLSF_FLAG_FREE)
+    {
+        tlsf_remove(tlsf, next);
+        TLSF_SET_NEXT(ptr, TLSF_NEXT(next), TLSF_FLAGS_OF(ptr));
+        next = TLSF_NEXT(ptr);
+    }
+    //before is also free?
+    if (TLSF_FLAGS_OF(ptr) & TLSF_FLAG_PREV_FREE)
+    {
+        prev = TLSF_BACK(ptr);
+        tlsf_remove(tlsf, prev);
+        TLSF_SET_NEXT(prev, next, TLSF_FLAGS_OF(prev));
+        ptr = prev;
+    }
+    TLSF_SET_NEXT(ptr, next, TLSF_FLAGS_OF(ptr) | TLSF_FLAG_FREE);
+    TLSF_SET_NEXT(next, TLSF_NEXT(next), TLSF_FLAGS_OF(next) | TLSF_FLAG_PREV_FREE);
+    TLSF_BACK(next) = ptr;
+    TLSF_SET_MARK(ptr);
+    tlsf_insert(tlsf, ptr);
+}
+
+//used slot. Free space at end is released
+static void tlsf_split(TLSF* tlsf, void* ptr, size_t len)
+{
+    void* next = TLSF_NEXT(ptr);
+    void* rest = (void*)(NUM(ptr) + SLOT_HEADER_SIZE + len + SLOT_FOOTER_SIZE);
+    if (NUM(rest) + TLSF_MIN_SLOT_FULL_SIZE > NUM(next))
+        return;
+    NEXT_SLOT(rest) = next;
+    TLSF_SET_NEXT(ptr, rest, TLSF_FLAGS_OF(ptr));
+    TLSF_SET_MARK(ptr);
+    tlsf_release(tlsf, rest);
+}
+
+static bool tlsf_grow(POOL* pool, size_t size, void* sp)
+{
+    void* last = pool->last_slot;
+    void* new_last;
+    if (TLSF_NEXT(last) != NULL)
+    {
+        error(ERROR_POOL_CORRUPTED);
+        return false;
+    }
+    //space for free list links
+    if (size < TLSF_MIN_DATA)
+        size = TLSF_MIN_DATA;
+    new_last = (void*)(NUM(last) + SLOT_HEADER_SIZE + size + SLOT_FOOTER_SIZE);
+    //check uint overflow and compare with stack
+    if (NUM(new_last) < NUM(last) || NUM(new_last) >= NUM(sp))
+    {
+        error(ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+    //_brk implementation
+    NEXT_SLOT(new_last) = NULL;
+    TLSF_SET_NEXT(last, new_last, TLSF_FLAGS_OF(last));
+    TLSF_SET_MARK(new_last);
+    pool->last_slot = new_last;
+    tlsf_release((TLSF*)pool->tlsf, last);
+    return true;
+}
+
+//free slot at end of pool? _brk implementation, return space to stack
+static void tlsf_trim(POOL* pool)
+{
+    void* prev;
+    if ((TLSF_FLAGS_OF(pool->last_slot) & TLSF_FLAG_PREV_FREE) == 0)
+        return;
+    prev = TLSF_BACK(pool->last_slot);
+    tlsf_remove((TLSF*)pool->tlsf, prev);
+    TLSF_SET_NEXT(prev, NULL, TLSF_FLAGS_OF(prev) & ~TLSF_FLAG_FREE);
+    TLSF_SET_MARK(prev);
+    pool->last_slot = prev;
+}
+
+static void* pool_tlsf_malloc(POOL* pool, size_t size, void* sp)
+{
+    TLSF* tlsf = (TLSF*)pool->tlsf;
+    size_t len, class_size, tail;
+    int fl, sl;
+    void *ptr, *next;
+
+    if (size == 0)
+        return NULL;
+    len = ALIGN(size);
+    if (len < TLSF_MIN_DATA)
+        len = TLSF_MIN_DATA;
+    class_size = len;
+    if (len < size || !tlsf_round(&class_size))
+    {
+        error(ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+    tlsf_mapping(class_size, &fl, &sl);
+    ptr = tlsf_find(tlsf, fl, sl);
+    if (ptr == NULL)
+    {
+        class_size = ALIGN(class_size);
+        //free slot at end of pool will be merged with grown space
+        tail = 0;
+        if (TLSF_FLAGS_OF(pool->last_slot) & TLSF_FLAG_PREV_FREE)
+            tail = TLSF_SIZE(TLSF_BACK(pool->last_slot)) + SLOT_HEADER_SIZE + SLOT_FOOTER_SIZE;
+        if (!tlsf_grow(pool, class_size > tail ? class_size - tail : 0, sp))
+            return NULL;
+        ptr = tlsf_find(tlsf, fl, sl);
+        if (ptr == NULL)
+        {
+            error(ERROR_POOL_CORRUPTED);
+            return NULL;
+        }
+    }
+    tlsf_remove(tlsf, ptr);
+    TLSF_SET_NEXT(ptr, TLSF_NEXT(ptr), TLSF_FLAGS_OF(ptr) & ~TLSF_FLAG_FREE);
+    next = TLSF_NEXT(ptr);
+    TLSF_SET_NEXT(next, TLSF_NEXT(next), TLSF_FLAGS_OF(next) & ~TLSF_FLAG_PREV_FREE);
+    tlsf_split(tlsf, ptr, len);
+    return ptr;
+}
+
+static void pool_tlsf_free(POOL* pool, void* ptr)
+{
+    if (
+         //out of pool?
+         NUM(ptr) < NUM(pool->first_slot) || NUM(ptr) >= NUM(pool->last_slot)
+         //already free?
+         || (TLSF_FLAGS_OF(ptr) & TLSF_FLAG_FREE)
+         //next after current slot is broken?
+         || NUM(TLSF_NEXT(ptr)) <= NUM(ptr) || NUM(TLSF_NEXT(ptr)) > NUM(pool->last_slot))
+    {
+        error(ERROR_POOL_CORRUPTED);
+        return;
+    }
+    tlsf_release((TLSF*)pool->tlsf, ptr);
+    tlsf_trim(pool);
+}
+
+static void* pool_tlsf_realloc(POOL* pool, void* ptr, size_t size, void* sp)
+{
+    TLSF* tlsf = (TLSF*)pool->tlsf;
+    void *next, *res;
+    unsigned int cur_size, avail;
+    size_t len = ALIGN(size);
+    if (len < TLSF_MIN_DATA)
+        len = TLSF_MIN_DATA;
+
+    cur_size = TLSF_SIZE(ptr);
+    next = TLSF_NEXT(ptr);
+    //at end of pool? grow!
+    if (len > cur_size && next == pool->last_slot && tlsf_grow(pool, len - cur_size, sp))
+        next = TLSF_NEXT(ptr);
+    //next is free? append!
+    if (len > cur_size && (TLSF_FLAGS_OF(next) & TLSF_FLAG_FREE) &&
+        cur_size + SLOT_HEADER_SIZE + TLSF_SIZE(next) + SLOT_FOOTER_SIZE >= len)
+    {
+        tlsf_remove(tlsf, next);
+        TLSF_SET_NEXT(ptr, TLSF_NEXT(next), TLSF_FLAGS_OF(ptr));
+        next = TLSF_NEXT(ptr);
+        TLSF_SET_NEXT(next, TLSF_NEXT(next), TLSF_FLAGS_OF(next) & ~TLSF_FLAG_PREV_FREE);
+        TLSF_SET_MARK(ptr);
+    }
+    //slot enough size? Free space at end is released
+    if (TLSF_SIZE(ptr) >= len)
+    {
+        tlsf_split(tlsf, ptr, len);
+        tlsf_trim(pool);
+        return ptr;
+    }
+
+    //free slot before? Move down, with free slot after if required
+    if (TLSF_FLAGS_OF(ptr) & TLSF_FLAG_PREV_FREE)
+    {
+        res = TLSF_BACK(ptr);
+        avail = TLSF_SIZE(res) + SLOT_HEADER_SIZE + SLOT_FOOTER_SIZE + TLSF_SIZE(ptr);
+        if (TLSF_FLAGS_OF(next) & TLSF_FLAG_FREE)
+            avail += SLOT_HEADER_SIZE + TLSF_SIZE(next) + SLOT_FOOTER_SIZE;
+        if (avail >= len)
+        {
+            if (TLSF_FLAGS_OF(next) & TLSF_FLAG_FREE)
+            {
+                tlsf_remove(tlsf, next);
+                next = TLSF_NEXT(next);
+                TLSF_SET_NEXT(next, TLSF_NEXT(next), TLSF_FLAGS_OF(next) & ~TLSF_FLAG_PREV_FREE);
+            }
+            tlsf_remove(tlsf, res);
+            TLSF_SET_NEXT(res, next, TLSF_FLAGS_OF(res) & ~TLSF_FLAG_FREE);
+            memmove(res, ptr, cur_size);
+            TLSF_SET_MARK(res);
+            tlsf_split(tlsf, res, len);
+            tlsf_trim(pool);
+            return res;
+        }
+    }
+
+    //can't extend. Allocate in other place and copy.
+    res = pool_tlsf_malloc(pool, size, sp);
+    if (res)
+    {
+        memcpy(res, ptr, cur_size);
+        tlsf_release(tlsf, ptr);
+        tlsf_trim(pool);
+    }
+    return res;
+}
+
+void pool_init_tlsf(POOL* pool, void* data)
+{
+    TLSF* tlsf;
+    data = pool_profile_init(pool, data);
+    tlsf = (TLSF*)ALIGN(NUM(data));
+    memset(tlsf, 0, sizeof(TLSF));
+    pool->tlsf = tlsf;
+    pool->free_slot = NULL;
+    // _sbrk implementation
+    pool->first_slot = pool->last_slot = (void*)(NUM(tlsf) + sizeof(TLSF) + SLOT_HEADER_SIZE);
+    NEXT_SLOT(pool->first_slot) = NULL;
+    TLSF_SET_MARK(pool->first_slot);
+}
+
+#endif //KERNEL_POOL_TLSF
+
 void pool_init(POOL* pool, void* data)
 {
+    data = pool_profile_init(pool, data);
     // _sbrk implementation
     pool->first_slot = pool->last_slot = (void*)(ALIGN(NUM(data)) + SLOT_HEADER_SIZE);
     NEXT_SLOT(pool->first_slot) = NULL;
     SET_MARK(pool->first_slot);
     pool->free_slot = NULL;
+    pool->tlsf = NULL;
 }
 
+static void pool_free_internal(POOL* pool, void* ptr);
+
 static bool grow(POOL* pool, size_t size, void* sp)
 {
     register void *new_last;
@@ -104,17 +562,21 @@ static bool grow(POOL* pool, size_t size, void* sp)
     SET_MARK(pool->last_slot);
     SET_MARK(new_last);
 
-    pool_free(pool, pool->last_slot);
+    pool_free_internal(pool, pool->last_slot);
     pool->last_slot = new_last;
     return true;
 }
 
-void* pool_malloc(POOL* pool, size_t size, void* sp)
+static void* pool_malloc_internal(POOL* pool, size_t size, void* sp)
 {
     size_t len;
     register void *free_before, *next_slot, *new_slot, *cur;
     int i;
 
+#if (KERNEL_POOL_TLSF)
+    if (pool->tlsf != NULL)
+        return pool_tlsf_malloc(pool, size, sp);
+#endif //KERNEL_POOL_TLSF
     //optimize for ARM 32bit align
     len = ALIGN(size);
     if (size == 0)
@@ -166,10 +628,29 @@ size_t pool_slot_size(POOL* poll, void* ptr)
 {
     if (ptr == NULL)
         return 0;
+#if (KERNEL_POOL_TLSF)
+    if (poll->tlsf != NULL)
+        return TLSF_SIZE(ptr);
+#endif //KERNEL_POOL_TLSF
     return NUM(NEXT_SLOT(ptr)) - NUM(ptr) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE;
 }
 
-void* pool_realloc(POOL* pool, void* ptr, size_t size, void *sp)
+//free space at end of used slot
+static void split(POOL* pool, void* ptr, size_t len)
+{
+    void* next = NEXT_SLOT(ptr);
+    void* n = (void*)(NUM(ptr) + SLOT_HEADER_SIZE + SLOT_FOOTER_SIZE + len);
+    if (NUM(next) - NUM(n) < MIN_SLOT_FULL_SIZE)
+        return;
+    CLEAR_MARK(ptr);
+    NEXT_SLOT(n) = next;
+    NEXT_SLOT(ptr) = n;
+    SET_MARK(ptr);
+    SET_MARK(n);
+    pool_free_internal(pool, n);
+}
+
+static void* pool_realloc_internal(POOL* pool, void* ptr, size_t size, void *sp)
 {
     register void *next, *p, *n;
     void *res;
@@ -178,13 +659,17 @@ void* pool_realloc(POOL* pool, void* ptr, size_t size, void *sp)
     int i;
 
     if (ptr == NULL)
-        return pool_malloc(pool, len, sp);
-    next = NEXT_SLOT(ptr);
+        return pool_malloc_internal(pool, len, sp);
     if (len == 0)
     {
-        pool_free(pool, ptr);
+        pool_free_internal(pool, ptr);
         return NULL;
     }
+#if (KERNEL_POOL_TLSF)
+    if (pool->tlsf != NULL)
+        return pool_tlsf_realloc(pool, ptr, size, sp);
+#endif //KERNEL_POOL_TLSF
+    next = NEXT_SLOT(ptr);
     cur_size = pool_slot_size(pool, ptr);
 
     for (i = 0; i < 2; ++i)
@@ -215,42 +700,61 @@ void* pool_realloc(POOL* pool, void* ptr, size_t size, void *sp)
     }
 
     //slot enough size?
-    n = (void*)(NUM(ptr) + SLOT_HEADER_SIZE + SLOT_FOOTER_SIZE + len);
-    if (n <= next)
+    if (NUM(ptr) + SLOT_HEADER_SIZE + SLOT_FOOTER_SIZE + len <= NUM(next))
     {
-        //free space at end. Split slot
-        if (NUM(next) - NUM(n) >= MIN_SLOT_FULL_SIZE)
-        {
-            CLEAR_MARK(ptr);
-            NEXT_SLOT(n) = next;
-            NEXT_SLOT(ptr) = n;
-            SET_MARK(ptr);
-            SET_MARK(n);
-            pool_free(pool, n);
-        }
+        split(pool, ptr, len);
         return ptr;
     }
 
+    //free slot before? Move down
+    for (p = NULL, n = pool->free_slot; n != NULL && NUM(n) < NUM(ptr); p = n, n = NEXT_FREE(n))
+    {
+        if (NEXT_SLOT(n) != ptr)
+            continue;
+        if (NUM(n) + SLOT_HEADER_SIZE + SLOT_FOOTER_SIZE + len > NUM(next))
+            break;
+        if (p)
+            NEXT_FREE(p) = NEXT_FREE(n);
+        else
+            pool->free_slot = NEXT_FREE(n);
+        CLEAR_MARK(n);
+        CLEAR_MARK(ptr);
+        NEXT_SLOT(n) = next;
+        memmove(n, ptr, cur_size);
+        SET_MARK(n);
+        split(pool, n, len);
+        return n;
+    }
+
     //can't extend. Allocate in other place and copy.
-    res = pool_malloc(pool, size, sp);
+    res = pool_malloc_internal(pool, size, sp);
     if (res)
     {
         memcpy(res, ptr, cur_size);
-        pool_free(pool, ptr);
+        pool_free_internal(pool, ptr);
     }
     return res;
 }
 
-void pool_free(POOL* pool, void* ptr)
+static void pool_free_internal(POOL* pool, void* ptr)
 {
     register void* free_before;
     register void* free_after;
+    void* free_prev;
 
     if (ptr == NULL)
         return;
+#if (KERNEL_POOL_TLSF)
+    if (pool->tlsf != NULL)
+    {
+        pool_tlsf_free(pool, ptr);
+        return;
+    }
+#endif //KERNEL_POOL_TLSF
 
     //find free slots before and after our ptr
-    for (free_before = NULL, free_after = pool->free_slot; free_after != NULL && NUM(ptr) > NUM(free_after); free_before = free_after, free_after = NEXT_FREE(free_after)) {}
+    for (free_prev = free_before = NULL, free_after = pool->free_slot; free_after != NULL && NUM(ptr) > NUM(free_after);
+         free_prev = free_before, free_before = free_after, free_after = NEXT_FREE(free_after)) {}
 
     if (
          //pointer in free slots list?
@@ -292,7 +796,71 @@ void pool_free(POOL* pool, void* ptr)
         NEXT_SLOT(free_before) = NEXT_SLOT(ptr);
         NEXT_FREE(free_before) = free_after;
         SET_MARK(free_before);
+        ptr = free_before;
+        free_before = free_prev;
     }
+
+    //free tail? _brk implementation, return space to stack
+    if (NEXT_SLOT(ptr) == pool->last_slot)
+    {
+        if (free_before != NULL)
+            NEXT_FREE(free_before) = NULL;
+        else
+            pool->free_slot = NULL;
+        CLEAR_MARK(ptr);
+        CLEAR_MARK(pool->last_slot);
+        NEXT_SLOT(ptr) = NULL;
+        pool->last_slot = ptr;
+        SET_MARK(ptr);
+    }
+}
+
+void* pool_malloc(POOL* pool, size_t size, void* sp)
+{
+#if (KERNEL_ALLOC_PROFILING)
+    void* res;
+    void* caller = pool->caller != NULL ? pool->caller : __builtin_return_address(0);
+    pool->caller = NULL;
+    res = pool_malloc_internal(pool, size, sp);
+    if (res != NULL)
+        pool_profile_alloc(pool, res, caller);
+    return res;
+#else
+    return pool_malloc_internal(pool, size, sp);
+#endif //KERNEL_ALLOC_PROFILING
+}
+
+void* pool_realloc(POOL* pool, void* ptr, size_t size, void *sp)
+{
+#if (KERNEL_ALLOC_PROFILING)
+    void *res, *old_caller;
+    void* caller = pool->caller != NULL ? pool->caller : __builtin_return_address(0);
+    pool->caller = NULL;
+    old_caller = NULL;
+    if (ptr != NULL)
+    {
+        old_caller = SLOT_CALLER(ptr);
+        pool_profile_free(pool, ptr);
+    }
+    res = pool_realloc_internal(pool, ptr, size, sp);
+    if (res != NULL)
+        pool_profile_alloc(pool, res, caller);
+    //failed, original slot is still allocated
+    else if (ptr != NULL && size != 0)
+        pool_profile_alloc(pool, ptr, old_caller);
+    return res;
+#else
+    return pool_realloc_internal(pool, ptr, size, sp);
+#endif //KERNEL_ALLOC_PROFILING
+}
+
+void pool_free(POOL* pool, void* ptr)
+{
+#if (KERNEL_ALLOC_PROFILING)
+    if (ptr != NULL)
+        pool_profile_free(pool, ptr);
+#endif //KERNEL_ALLOC_PROFILING
+    pool_free_internal(pool, ptr);
 }
 
 #if (KERNEL_PROFILING)
@@ -302,9 +870,90 @@ void* pool_free_ptr(POOL* pool)
     return pool->last_slot + SLOT_HEADER_SIZE;
 }
 
+#if (KERNEL_POOL_TLSF)
+#if (KERNEL_RANGE_CHECKING)
+static bool tlsf_check_marks(void* cur)
+{
+    //check header
+    if (*((unsigned int*)(cur) - 1) != RANGE_MARK)
+        return false;
+    //check footer
+    if (TLSF_NEXT(cur))
+        return *(unsigned int*)(NUM(TLSF_NEXT(cur)) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE) == RANGE_MARK_END;
+    //last slot
+    return *(unsigned int*)(cur) == RANGE_MARK_POOL_END;
+}
+#endif //(KERNEL_RANGE_CHECKING)
+
+static bool pool_tlsf_check(POOL* pool, void* sp)
+{
+    TLSF* tlsf = (TLSF*)pool->tlsf;
+    register void *before, *cur;
+    unsigned int free_slots = 0;
+    bool prev_free = false;
+    int fl, sl;
+    //basic check
+    if (pool->first_slot == NULL || pool->last_slot == NULL ||
+         NUM(pool->first_slot) > NUM(pool->last_slot) || TLSF_NEXT(pool->last_slot) != NULL)
+    {
+        error(ERROR_POOL_CORRUPTED);
+        return false;
+    }
+    if (NUM(sp) < NUM(pool->last_slot))
+    {
+        error(ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+    //check all slots first
+    for (before = NULL, cur = pool->first_slot; cur != NULL; before = cur, cur = TLSF_NEXT(cur))
+    {
+        if (NUM(cur) <= NUM(before) || NUM(cur) > NUM(pool->last_slot) ||
+            //flag of free slot before is not match or two free slots in a row
+            (((TLSF_FLAGS_OF(cur) & TLSF_FLAG_PREV_FREE) != 0) != prev_free) ||
+            (prev_free && (TLSF_FLAGS_OF(cur) & TLSF_FLAG_FREE)))
+        {
+            error(ERROR_POOL_CORRUPTED);
+            return false;
+        }
+#if (KERNEL_RANGE_CHECKING)
+        if (!tlsf_check_marks(cur))
+        {
+            error(ERROR_POOL_RANGE_CHECK_FAILED);
+            return false;
+        }
+#endif //(KERNEL_RANGE_CHECKING)
+        prev_free = (TLSF_FLAGS_OF(cur) & TLSF_FLAG_FREE) != 0;
+        if (prev_free)
+            ++free_slots;
+    }
+    //all free slots must be in lists
+    for (fl = 0; fl < TLSF_FL_COUNT; ++fl)
+        for (sl = 0; sl < TLSF_SL_COUNT; ++sl)
+            for (cur = tlsf->heads[fl][sl]; cur != NULL; cur = NEXT_FREE(cur))
+            {
+                if (free_slots == 0 || (TLSF_FLAGS_OF(cur) & TLSF_FLAG_FREE) == 0)
+                {
+                    error(ERROR_POOL_CORRUPTED);
+                    return false;
+                }
+                --free_slots;
+            }
+    if (free_slots)
+    {
+        error(ERROR_POOL_CORRUPTED);
+        return false;
+    }
+    return true;
+}
+#endif //KERNEL_POOL_TLSF
+
 bool pool_check(POOL* pool, void* sp)
 {
     register void *before, *cur;
+#if (KERNEL_POOL_TLSF)
+    if (pool->tlsf != NULL)
+        return pool_tlsf_check(pool, sp);
+#endif //KERNEL_POOL_TLSF
     //basic check
     if (pool->first_slot == NULL || pool->last_slot == NULL ||
          NUM(pool->first_slot) > NUM(pool->last_slot) ||
@@ -396,23 +1045,37 @@ bool pool_check(POOL* pool, void* sp)
 
 void pool_stat(POOL* pool, POOL_STAT* stat, void* sp)
 {
-    void *cur, *cur_free;
+    void *cur, *cur_free, *next;
     unsigned int size;
+    bool is_free;
     memset(stat, 0, sizeof(POOL_STAT));
     if (pool_check(pool, sp))
     {
         cur_free = pool->free_slot;
-        for (cur = pool->first_slot; cur != pool->last_slot; cur = NEXT_SLOT(cur))
+        for (cur = pool->first_slot; cur != pool->last_slot; cur = next)
         {
-            size = NUM(NEXT_SLOT(cur)) - NUM(cur) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE;
+#if (KERNEL_POOL_TLSF)
+            if (pool->tlsf != NULL)
+            {
+                next = TLSF_NEXT(cur);
+                is_free = (TLSF_FLAGS_OF(cur) & TLSF_FLAG_FREE) != 0;
+            }
+            else
+#endif //KERNEL_POOL_TLSF
+            {
+                next = NEXT_SLOT(cur);
+                is_free = (cur == cur_free);
+                if (is_free)
+                    cur_free = NEXT_FREE(cur_free);
+            }
+            size = NUM(next) - NUM(cur) - SLOT_HEADER_SIZE - SLOT_FOOTER_SIZE;
             //it's free slot?
-            if (cur == cur_free)
+            if (is_free)
             {
                 ++stat->free_slots;
                 if (size > stat->largest_free)
                     stat->largest_free = size;
                 stat->free += size;
-                cur_free = NEXT_FREE(cur_free);
             }
             else
             {
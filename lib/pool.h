@@ -10,7 +10,27 @@
 #include "../userspace/types.h"
 #include "kernel_config.h"
 
+#if (KERNEL_ALLOC_PROFILING)
+//size histogram of live slots: up to 16 bytes, up to 32, ... last one is for all above 1K
+#define POOL_PROFILE_MIN_SIZE                   16
+#define POOL_PROFILE_BUCKETS                    8
+
+typedef struct {
+    //NULL is for all other callers, when table is full
+    void* caller;
+    unsigned int live, peak, count;
+} POOL_SITE;
+
+typedef struct {
+    POOL_SITE sites[KERNEL_ALLOC_PROFILING];
+    unsigned int sizes[POOL_PROFILE_BUCKETS];
+} POOL_PROFILE;
+#endif //KERNEL_ALLOC_PROFILING
+
 void pool_init(POOL* pool, void* data);
+#if (KERNEL_POOL_TLSF)
+void pool_init_tlsf(POOL* pool, void* data);
+#endif //KERNEL_POOL_TLSF
 void* pool_malloc(POOL* pool, size_t size, void *sp);
 size_t pool_slot_size(POOL* poll, void* ptr);
 void* pool_realloc(POOL* pool, void* ptr, size_t size, void* sp);
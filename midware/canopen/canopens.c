@@ -20,9 +20,9 @@
 static void pdo_start_timer(CO* co)
 {
     CO_OD_ENTRY* entry = co_od_find_idx(co->od, CO_OD_ENTRY_EVENT_TIME_1TPDO);
-    if (entry == NULL)
+    if (entry == NULL || entry->data == 0)
         return;
-    timer_start_ms(co->tpdo.timer, entry->data);
+    timer_start_periodic_ms(co->tpdo.timer, entry->data);
 }
 
 static void pdo_send(CO* co, uint32_t cob_id, uint32_t data, uint32_t len)
@@ -60,7 +60,6 @@ void pdo_timeout(CO* co, uint32_t timer)
     int i;
     for (i = 0; i < co->tpdo.count; i++)
         pdo_send(co, co->tpdo.cob_id[i]->data, co->tpdo.od_var[i]->data, co->tpdo.od_var[i]->len & 0xff);
-    pdo_start_timer(co);
 }
 
 void pdo_init(CO* co)
@@ -160,8 +159,9 @@ static void heartbeat_init(CO* co)
         return;
     if (entry == NULL)
         return;
+    timer_stop(co->timers.heartbeat, COT_HEARTBEAT, HAL_CANOPEN);
     if (entry->data)
-        timer_start_ms(co->timers.heartbeat, entry->data);
+        timer_start_periodic_ms(co->timers.heartbeat, entry->data);
 }
 
 static inline void bus_init(CO* co) // can bus ready after init or restore after bus error
@@ -286,7 +286,6 @@ static inline void bus_state_change(CO* co)
 
 static inline void heartbeat_timeout(CO* co)
 {
-    heartbeat_init(co);
     co->out_msg.id = NODE_GUARD + (co->id & MSK_ID);
     co->out_msg.data.b0 = co->co_state;
     co->out_msg.data_len = 1;
@@ -335,7 +334,8 @@ static inline void co_sdo_comm_changed(CO* co, CO_OD_ENTRY* entry, uint32_t data
         switch (entry->idx)
         {
         case CO_OD_ENTRY_HEARTBEAT_TIME:
-            if ((entry->data == 0) && (data != 0))
+            //timer is periodic, restart with new period
+            if (entry->data != data)
             {
                 entry->data = data;
                 heartbeat_init(co);
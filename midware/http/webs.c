@@ -261,13 +261,14 @@ static void webs_tx(WEBS* webs, WEBS_SESSION* session)
     TCP_STACK* tcp_stack;
     tcp_stack = io_push(session->io, sizeof(TCP_STACK));
     session->io->data_size = WEBS_IO_SIZE;
-    if (session->req_size - session->processed < WEBS_IO_SIZE)
+    //push last segment of response
+    if (session->req_size - session->processed <= WEBS_IO_SIZE)
     {
-        tcp_stack->flags = 0;
+        tcp_stack->flags = TCP_PSH;
         session->io->data_size = session->req_size - session->processed;
     }
     else
-        tcp_stack->flags = TCP_PSH;
+        tcp_stack->flags = 0;
     memcpy(io_data(session->io), session->req + session->processed, session->io->data_size);
     tcp_write(webs->tcpip, session->conn, session->io);
 }
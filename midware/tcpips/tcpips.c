@@ -250,8 +250,10 @@ static void tcpips_link_changed_internal(TCPIPS* tcpips, ETH_CONN_TYPE conn)
     if (tcpips->connected)
     {
         tcpips->seconds = 0;
-        timer_start_ms(tcpips->timer, 1000);
+        timer_start_periodic_ms(tcpips->timer, 1000);
     }
+    else
+        timer_stop(tcpips->timer, 0, HAL_TCPIP);
 }
 
 static inline void tcpips_link_changed(TCPIPS* tcpips, ETH_CONN_TYPE conn)
@@ -307,18 +309,17 @@ void tcpips_init(TCPIPS* tcpips)
     tcps_init(tcpips);
 }
 
-static inline void tcpips_timer(TCPIPS* tcpips)
+static inline void tcpips_timer(TCPIPS* tcpips, unsigned int missed)
 {
     if (tcpips->connected)
     {
-        ++tcpips->seconds;
+        tcpips->seconds += missed + 1;
         //forward to others
         arps_timer(tcpips, tcpips->seconds);
         icmps_timer(tcpips, tcpips->seconds);
 #if (IP_FRAGMENTATION)
         ips_timer(tcpips, tcpips->seconds);
 #endif //IP_FRAGMENTATION
-        timer_start_ms(tcpips->timer, 1000);
     }
 }
 
@@ -339,7 +340,7 @@ static inline void tcpips_request(TCPIPS* tcpips, IPC* ipc)
         tcpips_close(tcpips);
         break;
     case IPC_TIMEOUT:
-        tcpips_timer(tcpips);
+        tcpips_timer(tcpips, ipc->param3);
         break;
     case TCPIP_GET_CONN_STATE:
         tcpips_get_conn_state(tcpips, ipc->process);
@@ -1098,7 +1098,9 @@ static inline void tcps_rx_syn_sent(TCPIPS* tcpips, IO* io, HANDLE tcb_handle)
     {
         if (ack_diff)
         {
-            ++tcb->rcv_nxt;
+            //RCV.NXT = SEG.SEQ + 1, SND.UNA = SEG.ACK
+            tcb->rcv_nxt = be2int(tcp->seq_be) + 1;
+            tcb->snd_una = ack;
             tcps_set_state(tcb, TCP_STATE_ESTABLISHED);
             //inform user connected successfully
             ipc_post_inline(tcb->process, HAL_CMD(HAL_TCP, IPC_OPEN), tcb_handle, tcb_handle, 0);
@@ -1175,6 +1177,7 @@ void tcps_init(TCPIPS* tcpips)
 {
     so_create(&tcpips->tcps.listen, sizeof(TCP_LISTEN_HANDLE), 1);
     so_create(&tcpips->tcps.tcbs, sizeof(TCP_TCB), 1);
+    tcpips->tcps.dynamic = TCPIP_DYNAMIC_RANGE_LO;
 }
 
 void tcps_link_changed(TCPIPS* tcpips, bool link)
@@ -30,6 +30,24 @@
 #endif
 #endif
 
+#ifdef POSIX
+//host port. SRAM is static array, see kernel/core/kposix.c
+extern unsigned int __posix_sram[];
+#ifndef SRAM_BASE
+#define SRAM_BASE                ((unsigned int)__posix_sram)
+#endif
+#ifndef SRAM_SIZE
+#define SRAM_SIZE                (4 * 1024 * 1024)
+#endif
+#ifndef IRQ_VECTORS_COUNT
+#define IRQ_VECTORS_COUNT        32
+#endif
+//GLOBAL is 3 pointers, 64 bit on 64 bit host
+#ifndef KERNEL_GLOBAL_SIZE
+#define KERNEL_GLOBAL_SIZE       (3 * __SIZEOF_POINTER__)
+#endif
+#endif //POSIX
+
 #ifdef ARM7
 #include "arm7/core_arm7.h"
 #endif
@@ -6,6 +6,8 @@
 
 #include "heap.h"
 #include "svc.h"
+#include "process.h"
+#include "kernel_config.h"
 
 HANDLE heap_create(unsigned int size)
 {
@@ -22,6 +24,10 @@ void heap_destroy(HANDLE heap)
 void* heap_malloc(HANDLE heap, unsigned int size)
 {
     void* ptr;
+#if (KERNEL_ALLOC_PROFILING)
+    //allocation site for profiling, passed thru process pool
+    __PROCESS->pool.caller = __builtin_return_address(0);
+#endif //KERNEL_ALLOC_PROFILING
     svc_call(SVC_HEAP_MALLOC, (unsigned int)&ptr, (unsigned int)heap, size);
     return ptr;
 }
@@ -30,3 +36,8 @@ void heap_free(void* ptr)
 {
     svc_call(SVC_HEAP_FREE, (unsigned int)ptr, 0, 0);
 }
+
+void heap_profile(HANDLE heap)
+{
+    svc_call(SVC_HEAP_PROFILE, (unsigned int)heap, 0, 0);
+}
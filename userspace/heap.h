@@ -14,5 +14,7 @@ void heap_destroy(HANDLE heap);
 
 void* heap_malloc(HANDLE heap, unsigned int size);
 void heap_free(void* ptr);
+//print allocation sites of heap. Only if kernel is built with allocation profiling
+void heap_profile(HANDLE heap);
 
 #endif // HEAP_H
@@ -17,7 +17,7 @@ void* io_data(IO* io)
 
 void* io_stack(IO* io)
 {
-    return (void*)((unsigned int)io + io->size - io->stack_size);
+    return (void*)((unsigned int)io + io->size - io->chain_size * sizeof(IO_FRAGMENT) - io->stack_size);
 }
 
 void* io_push(IO* io, unsigned int size)
@@ -44,7 +44,7 @@ void* io_pop(IO* io, unsigned int size)
 
 unsigned int io_get_free(IO* io)
 {
-    return io->size - io->data_offset - io->data_size - io->stack_size;
+    return io->size - io->data_offset - io->data_size - io->stack_size - io->chain_size * sizeof(IO_FRAGMENT);
 }
 
 unsigned int io_data_write(IO* io, const void* data, unsigned int size)
@@ -68,7 +68,7 @@ unsigned int io_data_append(IO* io, const void* data, unsigned int size)
 
 void io_reset(IO* io)
 {
-    io->data_size = io->stack_size = 0;
+    io->data_size = io->stack_size = io->chain_size = 0;
     io->data_offset = sizeof(IO);
 }
 
@@ -96,6 +96,79 @@ void io_show(IO* io)
     io_unhide(io, io->data_offset - sizeof(IO));
 }
 
+IO_FRAGMENT* io_chain_fragment(IO* io, unsigned int index)
+{
+    //fragments are stored backward from IO end, so table can grow without moving
+    return (IO_FRAGMENT*)((unsigned int)io + io->size) - index - 1;
+}
+
+static bool io_chain_grow(IO* io)
+{
+    void* stack;
+    if (io_get_free(io) < sizeof(IO_FRAGMENT))
+        return false;
+    stack = io_stack(io);
+    memmove(stack - sizeof(IO_FRAGMENT), stack, io->stack_size);
+    ++io->chain_size;
+    return true;
+}
+
+bool io_chain_append(IO* io, void* ptr, unsigned int len)
+{
+    IO_FRAGMENT* fragment;
+    if (!io_chain_grow(io))
+        return false;
+    fragment = io_chain_fragment(io, io->chain_size - 1);
+    fragment->ptr = ptr;
+    fragment->len = len;
+    return true;
+}
+
+bool io_chain_prepend(IO* io, void* ptr, unsigned int len)
+{
+    IO_FRAGMENT* fragment;
+    if (!io_chain_grow(io))
+        return false;
+    //shift fragments one position to table end
+    fragment = io_chain_fragment(io, io->chain_size - 1);
+    memmove(fragment, fragment + 1, (io->chain_size - 1) * sizeof(IO_FRAGMENT));
+    fragment = io_chain_fragment(io, 0);
+    fragment->ptr = ptr;
+    fragment->len = len;
+    return true;
+}
+
+unsigned int io_get_size(IO* io)
+{
+    unsigned int i;
+    unsigned int size = io->data_size;
+    for (i = 0; i < io->chain_size; ++i)
+        size += io_chain_fragment(io, i)->len;
+    return size;
+}
+
+bool io_linearize(IO* io)
+{
+    unsigned int i;
+    IO_FRAGMENT* fragment;
+    void* stack;
+    if (io->chain_size == 0)
+        return true;
+    //fragments table is still in use while copying
+    if (io_get_free(io) < io_get_size(io) - io->data_size)
+        return false;
+    for (i = 0; i < io->chain_size; ++i)
+    {
+        fragment = io_chain_fragment(io, i);
+        memcpy(io_data(io) + io->data_size, fragment->ptr, fragment->len);
+        io->data_size += fragment->len;
+    }
+    stack = io_stack(io);
+    memmove(stack + io->chain_size * sizeof(IO_FRAGMENT), stack, io->stack_size);
+    io->chain_size = 0;
+    return true;
+}
+
 IO* io_create(unsigned int size)
 {
     IO* io;
@@ -105,6 +178,13 @@ IO* io_create(unsigned int size)
     return io;
 }
 
+bool io_share(IO* io, bool share)
+{
+    error(ERROR_OK);
+    svc_call(SVC_IO_SHARE, (unsigned int)io, (unsigned int)share, 0);
+    return get_last_error() == ERROR_OK;
+}
+
 int io_async_wait(HANDLE process, unsigned int cmd, unsigned int handle)
 {
     IPC ipc;
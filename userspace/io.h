@@ -29,11 +29,20 @@
  *      +-------------------------+
  *      |    user params stack    |
  *      +-------------------------+
+ *      |     chain fragments     |
+ *      +-------------------------+
+ *
+ *      Logical IO data is user data, followed by chain fragments in order
  */
 
+typedef struct {
+    void* ptr;
+    unsigned int len;
+} IO_FRAGMENT;
+
 typedef struct {
     HANDLE kio;
-    unsigned int size, data_offset, data_size, stack_size;
+    unsigned int size, data_offset, data_size, stack_size, chain_size;
 } IO;
 
 #pragma pack(pop)
@@ -140,6 +149,48 @@ void io_unhide(IO* io, unsigned int size);
 */
 void io_show(IO* io);
 
+/**
+    \brief get IO chain fragment
+    \param io: IO pointer
+    \param index: fragment index, less than io->chain_size
+    \retval fragment pointer
+*/
+IO_FRAGMENT* io_chain_fragment(IO* io, unsigned int index);
+
+/**
+    \brief append external buffer to end of IO chain. Buffer is not copied and must be valid till IO completion
+    \details Only receivers, created with REX_FLAG_IO_CHAIN, are getting chain as is. For others kernel is
+    linearizing IO on send. If IO free space is not enough, send is failed with ERROR_IO_BUFFER_TOO_SMALL
+    \param io: IO pointer
+    \param ptr: buffer pointer
+    \param len: buffer length
+    \retval true on success
+*/
+bool io_chain_append(IO* io, void* ptr, unsigned int len);
+
+/**
+    \brief insert external buffer to head of IO chain, right after user data
+    \param io: IO pointer
+    \param ptr: buffer pointer
+    \param len: buffer length
+    \retval true on success
+*/
+bool io_chain_prepend(IO* io, void* ptr, unsigned int len);
+
+/**
+    \brief get logical IO size: user data and all chain fragments
+    \param io: IO pointer
+    \retval size
+*/
+unsigned int io_get_size(IO* io);
+
+/**
+    \brief copy all chain fragments to user data. Called by kernel on send to receiver without REX_FLAG_IO_CHAIN
+    \param io: IO pointer
+    \retval true on success, false if IO free space is not enough
+*/
+bool io_linearize(IO* io);
+
 /**
     \brief creates IO
     \param size: size of io without header
@@ -147,6 +198,16 @@ void io_show(IO* io);
 */
 IO* io_create(unsigned int size);
 
+/**
+    \brief switch IO to shared read-only mode. Owner can send shared IO to several processes at once,
+    every receiver must complete IO back to owner. IO is freed on last completion, if destroyed by owner.
+    Up to 8 grants at once. Only receiver, holding grant, can forward IO or complete it back
+    \param io: IO pointer
+    \param share: true to share, false to return to exclusive mode
+    \retval true on success, false if IO is granted now
+*/
+bool io_share(IO* io, bool share);
+
 /**
     \brief send IO write request to another process
     \param process: receiver process
@@ -17,6 +17,8 @@ static int ipc_index(HANDLE wait_process, unsigned int cmd, unsigned int param1)
 {
     int i;
     unsigned int head = __GLOBAL->process->ipcs.head;
+    if (!ipc_filter_present(&__GLOBAL->process->ipcs_filter, __GLOBAL->process->ipcs.size, wait_process, cmd))
+        return -1;
     for (i = __GLOBAL->process->ipcs.tail; i != head; i = RB_ROUND(&__GLOBAL->process->ipcs, i + 1))
         if (((IPC_ITEM(i)->process == wait_process) || (wait_process == ANY_HANDLE)) && ((IPC_ITEM(i)->cmd == cmd) || (cmd == ANY_CMD)) &&
              ((IPC_ITEM(i)->param1 == param1) || (param1 == ANY_HANDLE)))
@@ -37,9 +39,22 @@ static IPC* ipc_peek(int index, IPC* ipc)
     }
     memcpy(ipc, IPC_ITEM(__GLOBAL->process->ipcs.tail), sizeof(IPC));
     rb_get(&__GLOBAL->process->ipcs);
+    ++__GLOBAL->process->ipcs_filter.taken[ipc_filter_hash(ipc->process, ipc->cmd)];
+    //free space for blocked sender
+    if (__GLOBAL->process->ipcs_blocked)
+        svc_call(SVC_IPC_UNBLOCK, 0, 0, 0);
     return ipc;
 }
 
+static void ipc_post_svc(unsigned int num, IPC* ipc)
+{
+    //receiver queue is full. Repeat after wakeup
+    do {
+        error(ERROR_OK);
+        svc_call(num, (unsigned int)ipc, 0, 0);
+    } while (get_last_error() == ERROR_BUSY);
+}
+
 unsigned int ipc_remove(HANDLE process, unsigned int cmd, unsigned int param1)
 {
     unsigned int count;
@@ -52,7 +67,19 @@ unsigned int ipc_remove(HANDLE process, unsigned int cmd, unsigned int param1)
 
 void ipc_post(IPC* ipc)
 {
-    svc_call(SVC_IPC_POST, (unsigned int)ipc, 0, 0);
+    ipc_post_svc(SVC_IPC_POST, ipc);
+}
+
+void ipc_post_batch(IPC* ipcs, unsigned int count)
+{
+    unsigned int posted;
+    //receiver queue is full. Post rest after wakeup
+    do {
+        error(ERROR_OK);
+        svc_call(SVC_IPC_POST_BATCH, (unsigned int)ipcs, count, (unsigned int)&posted);
+        ipcs += posted;
+        count -= posted;
+    } while (count && (get_last_error() == ERROR_BUSY));
 }
 
 void ipc_post_inline(HANDLE process, unsigned int cmd, unsigned int param1, unsigned int param2, unsigned int param3)
@@ -63,7 +90,7 @@ void ipc_post_inline(HANDLE process, unsigned int cmd, unsigned int param1, unsi
     ipc.param1 = param1;
     ipc.param2 = param2;
     ipc.param3 = param3;
-    svc_call(SVC_IPC_POST, (unsigned int)&ipc, 0, 0);
+    ipc_post_svc(SVC_IPC_POST, &ipc);
 }
 
 void ipc_ipost(IPC* ipc)
@@ -99,9 +126,16 @@ void ipc_read(IPC* ipc)
 
 void ipc_read_ex(IPC* ipc, HANDLE process, unsigned int cmd, unsigned int param1)
 {
+    int index;
     if (ipc_index(process, cmd, param1) < 0)
         svc_call(SVC_IPC_WAIT, process, cmd, param1);
-    ipc_peek(ipc_index(process, cmd, param1), ipc);
+    //wait failed, error is already set
+    if ((index = ipc_index(process, cmd, param1)) < 0)
+    {
+        ipc->param3 = get_last_error();
+        return;
+    }
+    ipc_peek(index, ipc);
 }
 
 void ipc_write(IPC* ipc)
@@ -120,14 +154,21 @@ void ipc_write(IPC* ipc)
         default:
             ipc->param3 = get_last_error();
         }
-        svc_call(SVC_IPC_POST, (unsigned int)ipc, 0, 0);
+        ipc_post_svc(SVC_IPC_POST, ipc);
     }
 }
 
 void call(IPC* ipc)
 {
-    svc_call(SVC_IPC_CALL, (unsigned int)ipc, 0, 0);
-    ipc_peek(ipc_index(ipc->process, ipc->cmd & ~HAL_REQ_FLAG, ipc->param1), ipc);
+    int index;
+    ipc_post_svc(SVC_IPC_CALL, ipc);
+    //no response, receiver is destroyed. Error is already set
+    if ((index = ipc_index(ipc->process, ipc->cmd & ~HAL_REQ_FLAG, ipc->param1)) < 0)
+    {
+        ipc->param3 = get_last_error();
+        return;
+    }
+    ipc_peek(index, ipc);
 }
 
 void ack(HANDLE process, unsigned int cmd, unsigned int param1, unsigned int param2, unsigned int param3)
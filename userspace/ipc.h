@@ -8,6 +8,7 @@
 #define IPC_H
 
 #include "types.h"
+#include "cc_macro.h"
 
 typedef struct _SYSTIME SYSTIME;
 
@@ -104,6 +105,42 @@ typedef struct {
     unsigned int param3;
 } IPC;
 
+//IPC queue filter. Counters of queued messages per (process, cmd) hash, not an index: selective lookup is
+//returning at once only if IPC is not on queue. Otherwise ring is scanned and matched IPC is moved to tail, both
+//linear in queue depth. Positions are not kept - kernel is posting from IRQ without lock with process, and
+//process is reordering ring on selective peek
+#define IPC_FILTER_SIZE                                     16
+
+typedef struct {
+    //written by kernel only
+    uint8_t posted[IPC_FILTER_SIZE];
+    //written by process only
+    uint8_t taken[IPC_FILTER_SIZE];
+} IPC_FILTER;
+
+__STATIC_INLINE unsigned int ipc_filter_hash(HANDLE process, unsigned int cmd)
+{
+    return (process ^ (process >> 4) ^ cmd ^ (cmd >> 16)) & (IPC_FILTER_SIZE - 1);
+}
+
+/**
+    \brief check, if IPC can be on queue
+    \details Wildcards and queues longer than counter range are always reported as possible
+    \param filter: IPC queue filter
+    \param size: IPC queue size
+    \param process: process or ANY_HANDLE wildcard
+    \param cmd: command or ANY_CMD wildcard
+    \retval \b false if IPC is not on queue for sure
+*/
+__STATIC_INLINE bool ipc_filter_present(IPC_FILTER* filter, unsigned int size, HANDLE process, unsigned int cmd)
+{
+    unsigned int hash;
+    if (process == ANY_HANDLE || cmd == ANY_CMD || size > 256)
+        return true;
+    hash = ipc_filter_hash(process, cmd);
+    return (uint8_t)(filter->posted[hash] - filter->taken[hash]) != 0;
+}
+
 /** \addtogroup IPC IPC
     IPC is sending messages from sender process to receiver
 
@@ -112,6 +149,7 @@ typedef struct {
 
 /**
     \brief remove IPCs from queue
+    \details Not queued IPC is rejected by queue filter at once, otherwise cost is linear in queue depth
     \param process: process or ANY_HANDLE wildcard
     \param cmd: command or ANY_CMD wildcard
     \param param1: extra param, generally object handle or ANY_HANDLE wildcard
@@ -121,11 +159,22 @@ unsigned int ipc_remove(HANDLE process, unsigned int cmd, unsigned int param1);
 
 /**
     \brief post IPC
+    \details If receiver was created with REX_FLAG_IPC_BLOCK and it's queue is full, caller waits for free space
     \param ipc: IPC structure
     \retval none
 */
 void ipc_post(IPC* ipc);
 
+/**
+    \brief post few IPCs in single kernel call
+    \details Each receiver is waked up once, reschedule is made after all IPCs are posted.
+    If receiver was created with REX_FLAG_IPC_BLOCK and it's queue is full, rest of IPCs are posted after free space
+    \param ipcs: array of IPC structures
+    \param count: number of IPCs in array
+    \retval none
+*/
+void ipc_post_batch(IPC* ipcs, unsigned int count);
+
 /**
     \brief post IPC, inline version
     \param process: receiver process
@@ -149,7 +198,7 @@ void ipc_post_inline(HANDLE process, unsigned int cmd, unsigned int param1, unsi
 
 /**
     \brief post IPC
-    \details This version must be called for IRQ context
+    \details This version must be called for IRQ context. Full queue of REX_FLAG_IPC_BLOCK receiver sets ERROR_BUSY
     \param ipc: IPC structure
     \retval none
 */
@@ -175,6 +224,7 @@ void ipc_read(IPC* ipc);
 
 /**
     \brief read message fro process
+    \details Not queued IPC is rejected by queue filter at once, otherwise cost is linear in queue depth
     \param ipc: ipc to read
     \param process: target process. ANY_HANDLE - ignore
     \param cmd: cmd to waid, ANY_CMD - ignore
@@ -192,6 +242,7 @@ void ipc_write(IPC* ipc);
 
 /**
     \brief call to process, wait for response
+    \details If receiver is destroyed before response, error is set and returned in param3
     \param IPC: ipc to call
     \retval none
 */
@@ -0,0 +1,21 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef POSIX_DRIVER_H
+#define POSIX_DRIVER_H
+
+#include "../process.h"
+
+//POSIX host virtual hardware. Every driver is running as separate process
+
+//stdout stream, set as SYS_OBJ_STDOUT. Output is printed by host
+extern const REX __POSIX_CONSOLE;
+//ETH ports, wired in pairs. Set as SYS_OBJ_ETH
+extern const REX __POSIX_ETH;
+//RAM disk storage, HAL_FLASH. Single user
+extern const REX __POSIX_DISK;
+
+#endif // POSIX_DRIVER_H
@@ -125,3 +125,8 @@ void process_info()
 {
     svc_call(SVC_PROCESS_INFO, 0, 0, 0);
 }
+
+void process_get_stat(HANDLE process, PROCESS_STAT* stat)
+{
+    svc_call(SVC_PROCESS_GET_STAT, (unsigned int)process, (unsigned int)stat, 0);
+}
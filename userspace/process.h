@@ -28,6 +28,7 @@
 #include "core/core.h"
 #include "systime.h"
 #include "rb.h"
+#include "ipc.h"
 
 #define PROCESS_FLAGS_ACTIVE                                     (1 << 0)
 #define PROCESS_FLAGS_WAITING                                    (1 << 1)
@@ -46,7 +47,27 @@ typedef enum {
     PROCESS_SYNC_STREAM =        (0x5 << 4)
 }PROCESS_SYNC_TYPE;
 
+#define PROCESS_STAT_LATENCY_BUCKETS                             16
+
+typedef struct {
+    unsigned int switches_in, switches_out;
+    //switched out while still active (preemption, time slice) and while going to sleep
+    unsigned int preempted, voluntary;
+    //IPC messages received
+    unsigned int ipcs;
+    //longest continuous run
+    SYSTIME longest_run;
+    //wakeup to run latency. Bucket 0: < 1us, bucket n: 2^(n-1)..2^n - 1 us. Last bucket holds all above
+    unsigned int latency[PROCESS_STAT_LATENCY_BUCKETS];
+}PROCESS_STAT;
+
 #define REX_FLAG_PERSISTENT_NAME                                 (1 << 24)
+//block sender on full IPC queue instead of drop. IRQ and kernel senders will receive ERROR_BUSY
+#define REX_FLAG_IPC_BLOCK                                       (1 << 25)
+//process pool is TLSF, if KERNEL_POOL_TLSF is enabled. Control block is allocated in process memory
+#define REX_FLAG_POOL_TLSF                                       (1 << 26)
+//process handles IO chain fragments. Chained IO to other receivers is linearized by kernel
+#define REX_FLAG_IO_CHAIN                                        (1 << 27)
 
 typedef struct {
     const char* name;
@@ -54,6 +75,8 @@ typedef struct {
     unsigned int priority;
     unsigned int flags;
     void (*fn) (void);
+    //IPC queue size. If 0, KERNEL_IPC_COUNT is used
+    unsigned int ipc_size;
 }REX;
 
 typedef struct {
@@ -63,6 +86,9 @@ typedef struct {
     HANDLE stdout, stdin;
     const char* name;
     RB ipcs;
+    IPC_FILTER ipcs_filter;
+    //set by kernel, if senders are waiting for free space in IPC queue
+    bool ipcs_blocked;
     //follow:
     //IPC queue
     //name holder (if not persistent)
@@ -225,6 +251,14 @@ void process_switch_test();
 */
 void process_info();
 
+/**
+    \brief get process scheduling statistics. Requires KERNEL_PROCESS_STAT
+    \param process: handle of created process
+    \param stat: pointer to \ref PROCESS_STAT structure
+    \retval none
+*/
+void process_get_stat(HANDLE process, PROCESS_STAT* stat);
+
 /** \} */ // end of process group
 
 #endif // PROCESS_H
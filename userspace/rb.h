@@ -94,6 +94,40 @@ __STATIC_INLINE unsigned int rb_get(RB* rb)
     return offset;
 }
 
+/**
+    \brief put contiguous span of items in ring buffer
+    \details span is never wrapped, so on buffer end call it once again for rest
+    \param rb: pointer to initialized \ref RB structure
+    \param size: in - items required, out - items, that can be put without wrap
+    \retval index of first element from start, where need to put data
+*/
+__STATIC_INLINE unsigned int rb_put_span(RB* rb, unsigned int* size)
+{
+    register unsigned int offset = rb->head;
+    register unsigned int span = rb->tail > rb->head ? rb->tail - rb->head - 1 : rb->size - rb->head - (rb->tail ? 0 : 1);
+    if (*size > span)
+        *size = span;
+    rb->head = RB_ROUND(rb, rb->head + *size);
+    return offset;
+}
+
+/**
+    \brief get contiguous span of items from ring buffer
+    \details span is never wrapped, so on buffer end call it once again for rest
+    \param rb: pointer to initialized \ref RB structure
+    \param size: in - items required, out - items, that can be get without wrap
+    \retval index of first element from where we can get data
+*/
+__STATIC_INLINE unsigned int rb_get_span(RB* rb, unsigned int* size)
+{
+    register unsigned int offset = rb->tail;
+    register unsigned int span = rb->tail > rb->head ? rb->size - rb->tail : rb->head - rb->tail;
+    if (*size > span)
+        *size = span;
+    rb->tail = RB_ROUND(rb, rb->tail + *size);
+    return offset;
+}
+
 /**
     \brief get rb used size
     \param rb: pointer to initialized \ref RB structure
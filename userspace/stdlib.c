@@ -7,14 +7,22 @@
 #include "stdlib.h"
 #include "systime.h"
 #include "svc.h"
+#include "kernel_config.h"
 
 void* malloc(size_t size)
 {
+#if (KERNEL_ALLOC_PROFILING)
+    //allocation site for profiling
+    __PROCESS->pool.caller = __builtin_return_address(0);
+#endif //KERNEL_ALLOC_PROFILING
     return ((const LIB_STD*)__GLOBAL->lib[LIB_ID_STD])->pool_malloc(&__PROCESS->pool, size, get_sp());
 }
 
 void* realloc(void* ptr, size_t size)
 {
+#if (KERNEL_ALLOC_PROFILING)
+    __PROCESS->pool.caller = __builtin_return_address(0);
+#endif //KERNEL_ALLOC_PROFILING
     return ((const LIB_STD*)__GLOBAL->lib[LIB_ID_STD])->pool_realloc(&__PROCESS->pool, ptr, size, get_sp());
 }
 
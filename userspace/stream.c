@@ -57,6 +57,11 @@ void stream_stop_listen(HANDLE stream)
     svc_call(SVC_STREAM_STOP_LISTEN, (unsigned int)stream, 0, 0);
 }
 
+void stream_listen_watermark(HANDLE stream, unsigned int size, unsigned int timeout_us)
+{
+    svc_call(SVC_STREAM_LISTEN_WATERMARK, (unsigned int)stream, size, timeout_us);
+}
+
 unsigned int stream_write_no_block(HANDLE handle, const char* buf, unsigned int size)
 {
     unsigned int written = size;
@@ -99,6 +104,34 @@ bool stream_read(HANDLE handle, char* buf, unsigned int size)
     return get_last_error() == ERROR_OK;
 }
 
+bool stream_acquire_read(HANDLE handle, char** ptr, unsigned int* len)
+{
+    error(ERROR_OK);
+    svc_call(SVC_STREAM_ACQUIRE_READ, (unsigned int)handle, (unsigned int)ptr, (unsigned int)len);
+    return get_last_error() == ERROR_OK;
+}
+
+bool stream_release_read(HANDLE handle, unsigned int size)
+{
+    error(ERROR_OK);
+    svc_call(SVC_STREAM_RELEASE_READ, (unsigned int)handle, size, 0);
+    return get_last_error() == ERROR_OK;
+}
+
+bool stream_acquire_write(HANDLE handle, char** ptr, unsigned int* len)
+{
+    error(ERROR_OK);
+    svc_call(SVC_STREAM_ACQUIRE_WRITE, (unsigned int)handle, (unsigned int)ptr, (unsigned int)len);
+    return get_last_error() == ERROR_OK;
+}
+
+bool stream_release_write(HANDLE handle, unsigned int size)
+{
+    error(ERROR_OK);
+    svc_call(SVC_STREAM_RELEASE_WRITE, (unsigned int)handle, size, 0);
+    return get_last_error() == ERROR_OK;
+}
+
 void stream_flush(HANDLE stream)
 {
     svc_call(SVC_STREAM_FLUSH, (unsigned int)stream, 0, 0);
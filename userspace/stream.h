@@ -75,6 +75,19 @@ void stream_ilisten(HANDLE stream, unsigned int param, HAL hal);
 */
 void stream_stop_listen(HANDLE stream);
 
+/**
+    \brief set STREAM listener watermark
+    \details Listener is informed only when size bytes are in stream, or data is waiting longer than timeout.
+    Setting is kept, while same process is listening again. \ref stream_stop_listen or other listener is
+    resetting it: by default listener is informed on any byte.
+    Can be set only by current listener, after \ref stream_listen.
+    \param stream: created STREAM object
+    \param size: bytes count to inform listener. Limited by stream size
+    \param timeout_us: max time in us, data is waiting before informing listener. 0 - wait for size forever
+    \retval none
+*/
+void stream_listen_watermark(HANDLE stream, unsigned int size, unsigned int timeout_us);
+
 /**
     \brief write to STREAM handle without blocking
     \param handle: handle of created stream
@@ -129,6 +142,43 @@ unsigned int stream_iread_no_block(HANDLE handle, const char* buf, unsigned int
 */
 bool stream_read(HANDLE handle, char* buf, unsigned int size);
 
+/**
+    \brief acquire contiguous STREAM data to parse in place, without copy
+    \details Data is not removed from stream till \ref stream_release_read. While acquired, other reads are returning nothing.
+    On ring wrap only first part is acquired, call again after release for rest.
+    \param handle: handle of opened stream
+    \param ptr: pointer to data
+    \param len: size of data
+    \retval true on ok
+*/
+bool stream_acquire_read(HANDLE handle, char** ptr, unsigned int* len);
+
+/**
+    \brief release data, acquired by \ref stream_acquire_read
+    \param handle: handle of opened stream
+    \param size: bytes consumed, clamped to acquired size. Rest remains in stream
+    \retval true on ok, false if not acquired or stream was flushed after acquire
+*/
+bool stream_release_read(HANDLE handle, unsigned int size);
+
+/**
+    \brief acquire contiguous STREAM free space to fill in place, without copy
+    \details Data is not visible to readers till \ref stream_release_write. While acquired, other writes are returning nothing.
+    \param handle: handle of opened stream
+    \param ptr: pointer to free space
+    \param len: size of free space
+    \retval true on ok
+*/
+bool stream_acquire_write(HANDLE handle, char** ptr, unsigned int* len);
+
+/**
+    \brief commit data, filled after \ref stream_acquire_write
+    \param handle: handle of opened stream
+    \param size: bytes written, clamped to acquired size
+    \retval true on ok, false if not acquired or stream was flushed after acquire
+*/
+bool stream_release_write(HANDLE handle, unsigned int size);
+
 /**
     \brief flush STREAM
     \param stream: created STREAM object
@@ -33,6 +33,10 @@ typedef enum {
     //profiling
     SVC_PROCESS_SWITCH_TEST,
     SVC_PROCESS_INFO,
+    SVC_PROCESS_GET_STAT,
+    SVC_TRACE_READ,
+    SVC_TRACE_COUNT,
+    SVC_TRACE_LOST,
 
     SVC_IRQ_REGISTER,
     SVC_IRQ_UNREGISTER,
@@ -43,12 +47,15 @@ typedef enum {
     SVC_SYSTIME_HPET_SETUP,
     SVC_SYSTIME_SOFT_TIMER_CREATE,
     SVC_SYSTIME_SOFT_TIMER_START,
+    SVC_SYSTIME_SOFT_TIMER_START_PERIODIC,
     SVC_SYSTIME_SOFT_TIMER_STOP,
     SVC_SYSTIME_SOFT_TIMER_DESTROY,
 
     SVC_IPC_POST,
     SVC_IPC_WAIT,
     SVC_IPC_CALL,
+    SVC_IPC_POST_BATCH,
+    SVC_IPC_UNBLOCK,
 
     SVC_STREAM_CREATE,
     SVC_STREAM_OPEN,
@@ -63,9 +70,15 @@ typedef enum {
     SVC_STREAM_READ_NO_BLOCK,
     SVC_STREAM_FLUSH,
     SVC_STREAM_DESTROY,
+    SVC_STREAM_ACQUIRE_READ,
+    SVC_STREAM_RELEASE_READ,
+    SVC_STREAM_ACQUIRE_WRITE,
+    SVC_STREAM_RELEASE_WRITE,
+    SVC_STREAM_LISTEN_WATERMARK,
 
     SVC_IO_CREATE,
     SVC_IO_DESTROY,
+    SVC_IO_SHARE,
 
     SVC_OBJECT_SET,
     SVC_OBJECT_GET,
@@ -74,6 +87,7 @@ typedef enum {
     SVC_HEAP_DESTROY,
     SVC_HEAP_MALLOC,
     SVC_HEAP_FREE,
+    SVC_HEAP_PROFILE,
 
     SVC_ADD_POOL,
     SVC_SETUP_DBG,
@@ -93,12 +107,17 @@ typedef void (*STDOUT)(const char *const buf, unsigned int size, void* param);
     \details Same for every ARM, so defined here
     \retval stack pointer
 */
+#ifdef POSIX
+//host port. Process stack is not a part of process memory
+extern void* get_sp();
+#else
 __STATIC_INLINE void* get_sp()
 {
   void* result;
   __ASM volatile ("mov %0, sp" : "=r" (result));
   return result;
 }
+#endif //POSIX
 
 /**
     \brief core-dependent context raiser
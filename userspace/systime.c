@@ -110,6 +110,25 @@ void timer_istart_ms(HANDLE timer, unsigned int time_ms)
     timer_istart(timer, &time);
 }
 
+void timer_start_ms_slack(HANDLE timer, unsigned int time_ms, unsigned int slack_ms)
+{
+    SYSTIME time;
+    ms_to_systime(time_ms, &time);
+    svc_call(SVC_SYSTIME_SOFT_TIMER_START, (unsigned int)timer, (unsigned int)&time, slack_ms * 1000);
+}
+
+void timer_start_periodic(HANDLE timer, SYSTIME* period)
+{
+    svc_call(SVC_SYSTIME_SOFT_TIMER_START_PERIODIC, (unsigned int)timer, (unsigned int)period, 0);
+}
+
+void timer_start_periodic_ms(HANDLE timer, unsigned int period_ms)
+{
+    SYSTIME period;
+    ms_to_systime(period_ms, &period);
+    timer_start_periodic(timer, &period);
+}
+
 void timer_start_us(HANDLE timer, unsigned int time_us)
 {
     SYSTIME time;
@@ -195,6 +195,35 @@ void timer_start_ms(HANDLE timer, unsigned int time_ms);
 */
 void timer_istart_ms(HANDLE timer, unsigned int time_ms);
 
+/**
+    \brief start soft timer in ms units with allowed delay
+    \details kernel can delay timeout up to slack_ms to shoot it together with already
+    scheduled timers. This saves HPET interrupts and context switches.
+    \param timer soft timer handle
+    \param time_ms time in ms units
+    \param slack_ms max delay in ms units
+    \retval none.
+*/
+void timer_start_ms_slack(HANDLE timer, unsigned int time_ms, unsigned int slack_ms);
+
+/**
+    \brief start periodic soft timer
+    \details timer is re-armed by kernel on absolute schedule till stop. If previous IPC_TIMEOUT is
+    not received yet, no new IPC is posted. param3 of IPC_TIMEOUT is number of missed periods.
+    \param timer soft timer handle
+    \param period pointer to SYSTIME structure
+    \retval none.
+*/
+void timer_start_periodic(HANDLE timer, SYSTIME* period);
+
+/**
+    \brief start periodic soft timer in ms units
+    \param timer soft timer handle
+    \param period_ms period in ms units
+    \retval none.
+*/
+void timer_start_periodic_ms(HANDLE timer, unsigned int period_ms);
+
 /**
     \brief start soft timer in us units
     \param timer soft timer handle
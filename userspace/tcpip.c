@@ -20,6 +20,7 @@ HANDLE tcpip_create(unsigned int process_size, unsigned int priority, unsigned i
     rex.priority = priority;
     rex.flags = PROCESS_FLAGS_ACTIVE;
     rex.fn = tcpips_main;
+    rex.ipc_size = 0;
     return process_create(&rex);
 }
 
@@ -0,0 +1,56 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#include "trace.h"
+#include "stream.h"
+#include "svc.h"
+
+#define TRACE_DRAIN_CHUNK                       8
+
+unsigned int trace_read(TRACE* buf, unsigned int count)
+{
+    unsigned int readed = 0;
+    svc_call(SVC_TRACE_READ, (unsigned int)buf, count, (unsigned int)&readed);
+    return readed;
+}
+
+unsigned int trace_count()
+{
+    unsigned int count = 0;
+    svc_call(SVC_TRACE_COUNT, (unsigned int)&count, 0, 0);
+    return count;
+}
+
+//events are already removed from kernel buffer, reader must know about gap
+static void trace_drop(const TRACE* buf, unsigned int count)
+{
+    unsigned int i, lost;
+    for (i = 0, lost = 0; i < count; ++i)
+        lost += buf[i].event == TRACE_LOST ? buf[i].param1 : 1;
+    svc_call(SVC_TRACE_LOST, lost, 0, 0);
+}
+
+unsigned int trace_drain(HANDLE handle)
+{
+    TRACE buf[TRACE_DRAIN_CHUNK];
+    unsigned int readed, total, count, chunk;
+    //stream write is producing new events itself. Drain only already recorded
+    count = trace_count();
+    for (total = 0; total < count; total += readed)
+    {
+        chunk = count - total;
+        if (chunk > TRACE_DRAIN_CHUNK)
+            chunk = TRACE_DRAIN_CHUNK;
+        if ((readed = trace_read(buf, chunk)) == 0)
+            break;
+        if (!stream_write(handle, (const char*)buf, readed * sizeof(TRACE)))
+        {
+            trace_drop(buf, readed);
+            break;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,65 @@
+/*
+    RExOS - embedded RTOS
+    Copyright (c) 2011-2017, Alexey Kramarenko
+    All rights reserved.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/** \addtogroup trace trace
+    kernel event tracer. Enabled by KERNEL_TRACE in kernel config.
+
+    Each event is fixed-size binary \ref TRACE record, stamped by system uptime.
+    Records are written to stream as is, in little-endian MCU order.
+    \{
+ */
+
+#include "types.h"
+#include "systime.h"
+
+typedef enum {
+    TRACE_SWITCH = 0,                                                       //!< param1: next process, param2: previous process
+    TRACE_IPC_POST,                                                         //!< param1: sender, param2: receiver
+    TRACE_IPC_WAIT,                                                         //!< param1: process, param2: process waiting for
+    TRACE_WAKEUP,                                                           //!< param1: process
+    TRACE_IRQ_ENTER,                                                        //!< param1: vector
+    TRACE_IRQ_EXIT,                                                         //!< param1: vector
+    TRACE_STREAM_BLOCK,                                                     //!< param1: process, param2: stream handle
+    TRACE_STREAM_UNBLOCK,                                                   //!< param1: process, param2: stream handle
+    TRACE_TIMER,                                                            //!< param1: callback, param2: callback param
+    TRACE_LOST                                                              //!< param1: number of events, lost on buffer overflow
+}TRACE_EVENT;
+
+typedef struct {
+    SYSTIME time;
+    unsigned int event;
+    unsigned int param1, param2;
+}TRACE;
+
+/**
+    \brief read recorded events from kernel buffer
+    \param buf: buffer for events
+    \param count: max events count
+    \retval number of events readed
+*/
+unsigned int trace_read(TRACE* buf, unsigned int count);
+
+/**
+    \brief get number of recorded events
+    \retval number of events, including lost events record
+*/
+unsigned int trace_count();
+
+/**
+    \brief drain events, recorded before call, to stream
+    \details events, produced by drain itself, are left in buffer. Events of chunk, not written to stream,
+    are counted in next TRACE_LOST record
+    \param handle: opened stream handle
+    \retval number of events written
+*/
+unsigned int trace_drain(HANDLE handle);
+
+/** \} */ // end of trace group
+
+#endif // TRACE_H
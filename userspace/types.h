@@ -30,6 +30,12 @@ typedef struct {
     void* free_slot;
     void* first_slot;
     void* last_slot;
+    //TLSF control block, NULL for first-fit pool
+    void* tlsf;
+    //allocation sites table, NULL if profiling is disabled
+    void* profile;
+    //caller of next allocation, set by malloc wrapper
+    void* caller;
 } POOL;
 
 typedef struct {
@@ -19,6 +19,7 @@ HANDLE web_server_create(unsigned int process_size, unsigned int priority)
     rex.priority = priority;
     rex.flags = PROCESS_FLAGS_ACTIVE;
     rex.fn = webs_main;
+    rex.ipc_size = 0;
     return process_create(&rex);
 }
 